@@ -0,0 +1,294 @@
+#include <vector>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Model.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Navigation/CrowdManager.h>
+#include <Urho3D/Navigation/Navigable.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Unit/UnitType.hpp>
+
+#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
+#include <CastlesStrategy/Server/Managers/Map.hpp>
+#include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
+
+/// Runs units simulation with different units counts and writes JSON report with tick time percentiles and
+/// time spent by scene update and each manager. Usage:
+/// BenchmarkSimulation [--sizes <units per side, separated by comma>] [--ticks <count>] [--output <path>]
+const char *DEFAULT_BENCHMARK_SIZES = "100,1000,10000";
+const unsigned DEFAULT_BENCHMARK_WARMUP_TICKS = 60;
+const unsigned DEFAULT_BENCHMARK_TICKS = 600;
+const char *DEFAULT_BENCHMARK_OUTPUT = "BenchmarkSimulation.json";
+const float BENCHMARK_TIME_STEP = 1.0f / 60.0f;
+const float BENCHMARK_SPAWN_SCATTER = 8.0f;
+const unsigned BENCHMARK_UNIT_TYPE = 1;
+const unsigned BENCHMARK_RANDOM_SEED = 12345;
+/// Count of spawns in TestMap.xml, they also have crowd agents.
+const unsigned BENCHMARK_SPAWNS_COUNT = 4;
+
+struct BenchmarkResult
+{
+    unsigned unitsPerSide_;
+    unsigned ticks_;
+    /// Sum of units count at the beginning of each measured tick.
+    unsigned long long unitTicks_;
+    /// Managers hub statistics of measured ticks, in microseconds.
+    CastlesStrategy::TickStatistics tickStatistics_;
+    CastlesStrategy::TickStatistics sceneUpdateStatistics_;
+    std::vector <CastlesStrategy::TickStatistics> managersStatistics_;
+};
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+Urho3D::Scene *SetupScene (Urho3D::Context *context, unsigned maxAgents);
+
+void SetupUnitsManager (CastlesStrategy::UnitsManager *unitsManager, Urho3D::Context *context);
+void SetupMap (CastlesStrategy::Map *map, Urho3D::Context *context);
+void SpawnUnits (CastlesStrategy::UnitsManager *unitsManager, const CastlesStrategy::Map *map,
+        Urho3D::Scene *scene, unsigned unitsPerSide);
+
+BenchmarkResult RunBenchmark (Urho3D::Context *context, unsigned unitsPerSide, unsigned ticks);
+void WriteResult (const BenchmarkResult &result, Urho3D::JSONValue &output);
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::ParseArguments (argc, argv);
+    Urho3D::String sizesArgument = DEFAULT_BENCHMARK_SIZES;
+    unsigned ticks = DEFAULT_BENCHMARK_TICKS;
+    Urho3D::String outputPath = DEFAULT_BENCHMARK_OUTPUT;
+
+    const Urho3D::Vector <Urho3D::String> &arguments = Urho3D::GetArguments ();
+    for (unsigned index = 0; index + 1 < arguments.Size (); index += 2)
+    {
+        if (arguments [index] == "--sizes")
+        {
+            sizesArgument = arguments [index + 1];
+        }
+        else if (arguments [index] == "--ticks")
+        {
+            ticks = Urho3D::Max (1u, Urho3D::ToUInt (arguments [index + 1]));
+        }
+        else if (arguments [index] == "--output")
+        {
+            outputPath = arguments [index + 1];
+        }
+    }
+
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_INFO);
+    CastlesStrategy::Unit::RegisterObject (context);
+    SetupEngine (engine);
+
+    Urho3D::JSONFile report (context);
+    Urho3D::JSONValue &root = report.GetRoot ();
+    root ["timeStep"] = BENCHMARK_TIME_STEP;
+    root ["warmupTicks"] = DEFAULT_BENCHMARK_WARMUP_TICKS;
+    root ["ticks"] = ticks;
+
+    Urho3D::JSONArray results;
+    for (const Urho3D::String &size : sizesArgument.Split (','))
+    {
+        unsigned unitsPerSide = Urho3D::ToUInt (size);
+        if (unitsPerSide == 0)
+        {
+            continue;
+        }
+
+        BenchmarkResult result = RunBenchmark (context, unitsPerSide, ticks);
+        Urho3D::JSONValue resultOutput;
+        WriteResult (result, resultOutput);
+        results.Push (resultOutput);
+    }
+    root ["results"] = results;
+
+    Urho3D::File output (context, outputPath, Urho3D::FILE_WRITE);
+    if (!output.IsOpen () || !report.Save (output, "    "))
+    {
+        URHO3D_LOGERROR ("Can not write benchmark report to " + outputPath + "!");
+        return 1;
+    }
+
+    URHO3D_LOGINFO ("Benchmark report is written to " + outputPath + ".");
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "BenchmarkSimulation.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Scene *SetupScene (Urho3D::Context *context, unsigned maxAgents)
+{
+    Urho3D::Scene *scene = new Urho3D::Scene (context);
+    Urho3D::Node *planeNode = scene->CreateChild ("Plane");
+
+    planeNode->SetPosition ({50.0f, 0.0f, 50.0f});
+    planeNode->SetScale ({100.0f, 1.0f, 100.0f});
+    planeNode->CreateComponent <Urho3D::Navigable> ();
+
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::StaticModel *model = planeNode->CreateComponent <Urho3D::StaticModel> ();
+    model->SetModel (cache->GetResource <Urho3D::Model> ("Plane.mdl"));
+
+    Urho3D::NavigationMesh *navMesh = scene->CreateComponent <Urho3D::NavigationMesh> ();
+    navMesh->Build ();
+
+    Urho3D::CrowdManager *crowdManager = scene->CreateComponent <Urho3D::CrowdManager> ();
+    crowdManager->SetMaxAgents (maxAgents);
+    return scene;
+}
+
+void SetupUnitsManager (CastlesStrategy::UnitsManager *unitsManager, Urho3D::Context *context)
+{
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    unitsManager->LoadUnitsTypesFromXML (cache->GetResource <Urho3D::XMLFile> ("TestUnitTypes.xml")->GetRoot ());
+    unitsManager->LoadSpawnsFromXML (cache->GetResource <Urho3D::XMLFile> ("TestMap.xml")->GetRoot ());
+}
+
+void SetupMap (CastlesStrategy::Map *map, Urho3D::Context *context)
+{
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::XMLElement xml = cache->GetResource <Urho3D::XMLFile> ("TestMap.xml")->GetRoot ();
+
+    map->SetSize (xml.GetIntVector2 ("size"));
+    map->LoadRoutesFromXML (xml);
+}
+
+void SpawnUnits (CastlesStrategy::UnitsManager *unitsManager, const CastlesStrategy::Map *map,
+        Urho3D::Scene *scene, unsigned unitsPerSide)
+{
+    Urho3D::NavigationMesh *navMesh = scene->GetComponent <Urho3D::NavigationMesh> ();
+    unsigned routesCount = map->GetRoutes ().size ();
+    Urho3D::SetRandomSeed (BENCHMARK_RANDOM_SEED);
+
+    for (unsigned index = 0; index < unitsPerSide; index++)
+    {
+        for (bool belongsToFirst : {true, false})
+        {
+            unsigned route = index % routesCount;
+            const CastlesStrategy::Unit *unit = unitsManager->SpawnUnit (route, belongsToFirst, BENCHMARK_UNIT_TYPE);
+
+            // Units are scattered around first waypoint of their route instead of staying in one point near spawn.
+            Urho3D::Vector2 waypoint = map->GetWaypoint (route, 0, belongsToFirst);
+            Urho3D::Vector3 position = {
+                    waypoint.x_ + Urho3D::Random (-BENCHMARK_SPAWN_SCATTER, BENCHMARK_SPAWN_SCATTER), 0.0f,
+                    waypoint.y_ + Urho3D::Random (-BENCHMARK_SPAWN_SCATTER, BENCHMARK_SPAWN_SCATTER)};
+            unit->GetNode ()->SetWorldPosition (navMesh->FindNearestPoint (position));
+        }
+    }
+}
+
+BenchmarkResult RunBenchmark (Urho3D::Context *context, unsigned unitsPerSide, unsigned ticks)
+{
+    URHO3D_LOGINFO ("Running benchmark with " + Urho3D::String (unitsPerSide) + " units per side...");
+    Urho3D::SharedPtr <Urho3D::Scene> scene (SetupScene (context, unitsPerSide * 2 + BENCHMARK_SPAWNS_COUNT));
+    CastlesStrategy::ManagersHub managersHub (scene);
+
+    CastlesStrategy::Map *map = dynamic_cast <CastlesStrategy::Map *> (managersHub.GetManager (CastlesStrategy::MI_MAP));
+    SetupMap (map, context);
+
+    CastlesStrategy::UnitsManager *unitsManager =
+            dynamic_cast <CastlesStrategy::UnitsManager *> (managersHub.GetManager (CastlesStrategy::MI_UNITS_MANAGER));
+    SetupUnitsManager (unitsManager, context);
+    SpawnUnits (unitsManager, map, scene, unitsPerSide);
+
+    for (unsigned tick = 0; tick < DEFAULT_BENCHMARK_WARMUP_TICKS; tick++)
+    {
+        managersHub.HandleUpdate (BENCHMARK_TIME_STEP);
+    }
+
+    // Statistics must keep all measured ticks and must not include warm up ticks.
+    managersHub.SetStatisticsWindowSize (ticks);
+    BenchmarkResult result;
+    result.unitsPerSide_ = unitsPerSide;
+    result.ticks_ = ticks;
+    result.unitTicks_ = 0;
+
+    for (unsigned tick = 0; tick < ticks; tick++)
+    {
+        result.unitTicks_ += unitsManager->GetUnitsState ().Size ();
+        managersHub.HandleUpdate (BENCHMARK_TIME_STEP);
+    }
+
+    result.tickStatistics_ = managersHub.GetTickStatistics ();
+    result.sceneUpdateStatistics_ = managersHub.GetSceneUpdateStatistics ();
+    for (unsigned index = 0; index < CastlesStrategy::MI_MANAGERS_COUNT; index++)
+    {
+        result.managersStatistics_.push_back (
+                managersHub.GetManagerStatistics (static_cast <CastlesStrategy::ManagerIndex> (index)));
+    }
+    return result;
+}
+
+void WriteResult (const BenchmarkResult &result, Urho3D::JSONValue &output)
+{
+    const float NS_IN_US = 1000.0f;
+    double unitTicks = Urho3D::Max (1.0, static_cast <double> (result.unitTicks_));
+    double totalTimeNs = static_cast <double> (result.tickStatistics_.GetAverage ()) * NS_IN_US * result.ticks_;
+
+    output ["unitsPerSide"] = result.unitsPerSide_;
+    output ["averageUnitsCount"] = static_cast <double> (result.unitTicks_) / result.ticks_;
+    output ["tickTimeUsP50"] = result.tickStatistics_.GetPercentile (0.5f);
+    output ["tickTimeUsP99"] = result.tickStatistics_.GetPercentile (0.99f);
+    output ["tickTimeUsMax"] = result.tickStatistics_.GetMax ();
+    output ["tickTimeUsAverage"] = result.tickStatistics_.GetAverage ();
+    output ["nsPerUnitPerTick"] = totalTimeNs / unitTicks;
+
+    Urho3D::JSONValue breakdown;
+    breakdown ["SceneUpdate"] = result.sceneUpdateStatistics_.GetAverage ();
+    for (unsigned index = 0; index < CastlesStrategy::MI_MANAGERS_COUNT; index++)
+    {
+        CastlesStrategy::ManagerIndex managerIndex = static_cast <CastlesStrategy::ManagerIndex> (index);
+        breakdown [CastlesStrategy::ManagersHub::GetManagerName (managerIndex)] =
+                result.managersStatistics_ [index].GetAverage ();
+    }
+
+    output ["averageUsPerTickBreakdown"] = breakdown;
+    output ["unitsManagerNsPerUnitPerTick"] = static_cast <double> (
+            result.managersStatistics_ [CastlesStrategy::MI_UNITS_MANAGER].GetAverage ()) *
+            NS_IN_US * result.ticks_ / unitTicks;
+
+    URHO3D_LOGINFO (Urho3D::String (result.unitsPerSide_) + " units per side: p50 " +
+            Urho3D::String (result.tickStatistics_.GetPercentile (0.5f)) + " us, p99 " +
+            Urho3D::String (result.tickStatistics_.GetPercentile (0.99f)) + " us, " +
+            Urho3D::String (totalTimeNs / unitTicks) + " ns per unit per tick.");
+}
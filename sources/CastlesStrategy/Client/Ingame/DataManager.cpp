@@ -4,6 +4,7 @@
 
 #include <Utils/UniversalException.hpp>
 #include <CastlesStrategy/Client/Ingame/IngameActivity.hpp>
+#include <CastlesStrategy/Client/Ingame/UnitMotionInterpolator.hpp>
 #include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
 #include <CastlesStrategy/Shared/Village/Village.hpp>
 
@@ -24,7 +25,7 @@ DataManager::DataManager (IngameActivity *owner) : Urho3D::Object (owner->GetCon
         predictedOrderedUnitsCounts_ (),
         players_ ()
 {
-
+    SubscribeToEvent (Urho3D::E_NODEENABLEDCHANGED, URHO3D_HANDLER (DataManager, HandleNodeEnabledChanged));
 }
 
 DataManager::~DataManager ()
@@ -38,9 +39,12 @@ void DataManager::Update (float timeStep)
     PredictOrders (timeStep);
 }
 
-void DataManager::AddPrefabToObject (unsigned int nodeID)
+void DataManager::AddPrefabToObjects (const Urho3D::PODVector <unsigned int> &nodesIDs)
 {
-    objectsNodesToAddPrefabs_.Insert (nodeID);
+    for (unsigned int nodeID : nodesIDs)
+    {
+        objectsNodesToAddPrefabs_.Insert (nodeID);
+    }
 }
 
 void DataManager::RecruitUnit (unsigned int unitType)
@@ -97,6 +101,8 @@ void DataManager::LoadMapResources ()
             mapXml.GetVector3 ("defaultCameraPosition"), mapXml.GetQuaternion ("defaultCameraRotation"));
 
     owner_->GetFogOfWarManager ()->SetupFogOfWarMask (DEFAULT_FOG_OF_WAR_MASK_SIZE, mapXml.GetVector2 ("size"));
+    // Replicated map, player side and already added prefabs. Later prefabs are registered when they are added.
+    owner_->GetFogOfWarManager ()->RegisterFogOfWarMaterials (owner_->GetScene ());
 }
 
 const Urho3D::String &DataManager::GetMapName () const
@@ -314,6 +320,41 @@ const Urho3D::HashMap <Urho3D::String, DataManager::PlayerData> &DataManager::Ge
     return players_;
 }
 
+Urho3D::Node *DataManager::CreateObjectPrefab (Urho3D::Node *objectNode, const Urho3D::XMLElement &prefabXML)
+{
+    Urho3D::Node *prefab = objectNode->CreateChild (OBJECT_PREFAB_NODE_NAME, Urho3D::LOCAL);
+    prefab->LoadXML (prefabXML);
+    // Prefab files store their own node name, but prefab is found by name when object node is enabled or disabled.
+    prefab->SetName (OBJECT_PREFAB_NODE_NAME);
+
+    if (objectNode->HasComponent <Unit> () && !prefab->HasComponent <UnitMotionInterpolator> ())
+    {
+        prefab->CreateComponent <UnitMotionInterpolator> (Urho3D::LOCAL);
+    }
+
+    if (!objectNode->IsEnabled ())
+    {
+        prefab->SetDeepEnabled (false);
+    }
+    return prefab;
+}
+
+void DataManager::UpdateObjectPrefabEnabled (Urho3D::Node *objectNode)
+{
+    Urho3D::Node *prefab = objectNode->GetChild (OBJECT_PREFAB_NODE_NAME);
+    if (prefab != nullptr)
+    {
+        if (objectNode->IsEnabled ())
+        {
+            prefab->ResetDeepEnabled ();
+        }
+        else
+        {
+            prefab->SetDeepEnabled (false);
+        }
+    }
+}
+
 void DataManager::AttemptToAddPrefabs ()
 {
     auto iterator = objectsNodesToAddPrefabs_.Begin ();
@@ -327,9 +368,7 @@ void DataManager::AttemptToAddPrefabs ()
 
             if (unit != nullptr || village != nullptr)
             {
-                Urho3D::Node *prefab = node->CreateChild ("Prefab", Urho3D::LOCAL);
                 Urho3D::String prefabPath;
-
                 if (unit != nullptr)
                 {
                     const UnitType &unitType = GetUnitTypeByIndex (unit->GetUnitType ());
@@ -349,7 +388,8 @@ void DataManager::AttemptToAddPrefabs ()
                             prefabPath + "\" is not exists or is empty!");
                 }
 
-                prefab->LoadXML (prefabFile->GetRoot ());
+                Urho3D::Node *prefab = CreateObjectPrefab (node, prefabFile->GetRoot ());
+                owner_->GetFogOfWarManager ()->RegisterFogOfWarMaterials (prefab);
                 iterator = objectsNodesToAddPrefabs_.Erase (iterator);
                 continue;
             }
@@ -358,6 +398,16 @@ void DataManager::AttemptToAddPrefabs ()
     }
 }
 
+void DataManager::HandleNodeEnabledChanged (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    // Server disables nodes of dead units instead of removing them, prefab must be hidden together with unit node.
+    Urho3D::Node *node = static_cast <Urho3D::Node *> (eventData [Urho3D::NodeEnabledChanged::P_NODE].GetPtr ());
+    if (node != nullptr && node->GetScene () == owner_->GetScene () && node->HasComponent <Unit> ())
+    {
+        UpdateObjectPrefabEnabled (node);
+    }
+}
+
 void DataManager::PredictOrders (float timeStep)
 {
     if (!predictedOrders_.Empty ())
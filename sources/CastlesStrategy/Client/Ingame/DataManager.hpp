@@ -6,6 +6,8 @@
 
 namespace CastlesStrategy
 {
+const Urho3D::String OBJECT_PREFAB_NODE_NAME ("Prefab");
+
 class IngameActivity;
 struct RecruitmentOrder
 {
@@ -27,7 +29,7 @@ public:
     virtual ~DataManager ();
 
     void Update (float timeStep);
-    void AddPrefabToObject (unsigned int nodeID);
+    void AddPrefabToObjects (const Urho3D::PODVector <unsigned int> &nodesIDs);
     void RecruitUnit (unsigned int unitType);
     void SpawnUnit (unsigned int unitType);
     void LoadMapResources ();
@@ -60,8 +62,14 @@ public:
     void SetIsPlayerReadyForStart (const Urho3D::String &name, bool readyForStart);
     const Urho3D::HashMap <Urho3D::String, DataManager::PlayerData> &GetPlayers ();
 
+    /// Creates local prefab child of unit or village node. Prefab is disabled if object node is disabled.
+    static Urho3D::Node *CreateObjectPrefab (Urho3D::Node *objectNode, const Urho3D::XMLElement &prefabXML);
+    /// Hides prefab of disabled object node and restores it when node is enabled again.
+    static void UpdateObjectPrefabEnabled (Urho3D::Node *objectNode);
+
 private:
     void AttemptToAddPrefabs ();
+    void HandleNodeEnabledChanged (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
     void PredictOrders (float timeStep);
 
     IngameActivity *owner_;
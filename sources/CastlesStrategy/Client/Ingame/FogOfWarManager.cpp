@@ -1,10 +1,12 @@
 #include "FogOfWarManager.hpp"
+#include <algorithm>
+#include <cstring>
 #include <Urho3D/Graphics/Graphics.h>
-#include <Urho3D/Graphics/Material.h>
-#include <Urho3D/UI/Text3D.h>
+#include <Urho3D/Graphics/Drawable.h>
 
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Resource/Image.h>
+#include <Urho3D/Scene/SceneEvents.h>
 #include <CastlesStrategy/Client/Ingame/IngameActivity.hpp>
 
 namespace CastlesStrategy
@@ -18,12 +20,25 @@ FogOfWarManager::FogOfWarManager (IngameActivity *owner) :
         fogOfWarMaskImage_ (nullptr),
         fogOfWarMaskTexture_ (nullptr),
 
+        revealedEllipses_ (),
+        currentEllipses_ (),
+        dirtyRects_ (),
+        redrawRect_ (),
+        uploadBuffer_ (),
+        ellipseSpansCache_ (),
+        fullRedrawRequired_ (false),
+
+        fogOfWarMaterials_ (),
+        fogOfWarTexts_ (),
+        nodesToRegisterAgain_ (),
+        materialsParametersDirty_ (false),
+
         underFogColor_ (DEFAULT_UNDER_FOG_OF_WAR_MASK_COLOR),
         visibleColor_ (DEFAULT_VISIBLE_MASK_COLOR),
         mapUnitSize_ (),
         fogOfWarEnabled_ (true)
 {
-
+    SubscribeToEvent (Urho3D::E_SCENEPOSTUPDATE, URHO3D_HANDLER (FogOfWarManager, HandleScenePostUpdate));
 }
 
 FogOfWarManager::~FogOfWarManager ()
@@ -44,6 +59,11 @@ void FogOfWarManager::SetupFogOfWarMask (const Urho3D::IntVector2 &maskSize, con
     fogOfWarMaskTexture_->SetSize (maskSize.x_, maskSize.y_, Urho3D::Graphics::GetRGBAFormat (),
             Urho3D::TEXTURE_DYNAMIC);
     fogOfWarMaskTexture_->SetData (fogOfWarMaskImage_);
+    revealedEllipses_.Clear ();
+    dirtyRects_.Clear ();
+    ellipseSpansCache_.Clear ();
+    fullRedrawRequired_ = false;
+    materialsParametersDirty_ = true;
 
     Urho3D::ResourceCache *resourceCache = context_->GetSubsystem <Urho3D::ResourceCache> ();
     fogOfWarMaskTexture_->SetName (FOG_OF_WAR_MASK_TEXTURE_RESOURCE_NAME);
@@ -57,8 +77,12 @@ void FogOfWarManager::Update (float timeStep)
         if (untilNextUpdate_ <= 0.0f)
         {
             UpdateFogOfWarMap ();
-            UpdateMaterialsShaderParameters ();
-            ResetText3DMaterials ();
+            if (materialsParametersDirty_)
+            {
+                UpdateMaterialsShaderParameters ();
+                ResetText3DMaterials ();
+                materialsParametersDirty_ = false;
+            }
             untilNextUpdate_ = updateDelay_;
         }
         else
@@ -91,6 +115,8 @@ const Urho3D::Color &FogOfWarManager::GetUnderFogColor () const
 void FogOfWarManager::SetUnderFogColor (const Urho3D::Color &underFogColor)
 {
     underFogColor_ = underFogColor;
+    fullRedrawRequired_ = true;
+    materialsParametersDirty_ = true;
 }
 
 const Urho3D::Color &FogOfWarManager::GetVisibleColor () const
@@ -101,6 +127,7 @@ const Urho3D::Color &FogOfWarManager::GetVisibleColor () const
 void FogOfWarManager::SetVisibleColor (const Urho3D::Color &visibleColor)
 {
     visibleColor_ = visibleColor;
+    fullRedrawRequired_ = true;
 }
 
 bool FogOfWarManager::IsFogOfWarEnabled () const
@@ -110,51 +137,253 @@ bool FogOfWarManager::IsFogOfWarEnabled () const
 
 void FogOfWarManager::SetFogOfWarEnabled (bool fogOfWarEnabled)
 {
-    Urho3D::ResourceCache *resourceCache = context_->GetSubsystem <Urho3D::ResourceCache> ();
-    Urho3D::PODVector <Urho3D::Material *> materials;
-    resourceCache->GetResources <Urho3D::Material> (materials);
+    // Mask is not updated while fog of war is disabled.
+    if (fogOfWarEnabled && !fogOfWarEnabled_)
+    {
+        fullRedrawRequired_ = true;
+    }
+
+    fogOfWarEnabled_ = fogOfWarEnabled;
+    for (const Urho3D::SharedPtr <Urho3D::Material> &material : fogOfWarMaterials_)
+    {
+        material->SetShaderParameter ("FogOfWarEnabled", fogOfWarEnabled_ ? 1 : 0);
+    }
+    ResetText3DMaterials ();
+}
 
-    for (Urho3D::Material *material : materials)
+void FogOfWarManager::RegisterFogOfWarMaterials (Urho3D::Node *node)
+{
+    RegisterDrawablesMaterials (node);
+    nodesToRegisterAgain_.Push (Urho3D::WeakPtr <Urho3D::Node> (node));
+}
+
+void FogOfWarManager::RegisterDrawablesMaterials (Urho3D::Node *node)
+{
+    Urho3D::PODVector <Urho3D::Drawable *> drawables;
+    node->GetDerivedComponents <Urho3D::Drawable> (drawables, true);
+
+    for (Urho3D::Drawable *drawable : drawables)
     {
-        if (!material->GetShaderParameter ("FogOfWarEnabled").IsEmpty ())
+        Urho3D::Text3D *text = dynamic_cast <Urho3D::Text3D *> (drawable);
+        if (text != nullptr)
+        {
+            Urho3D::Material *material = text->GetMaterial ();
+            if (material != nullptr && !material->GetShaderParameter ("FogOfWarEnabled").IsEmpty () &&
+                    !fogOfWarTexts_.Contains (Urho3D::WeakPtr <Urho3D::Text3D> (text)))
+            {
+                fogOfWarTexts_.Push (Urho3D::WeakPtr <Urho3D::Text3D> (text));
+                RegisterFogOfWarMaterial (material);
+                text->SetMaterial (material);
+            }
+            continue;
+        }
+
+        for (const Urho3D::SourceBatch &batch : drawable->GetBatches ())
         {
-            material->SetShaderParameter ("FogOfWarEnabled", fogOfWarEnabled ? 1 : 0);
+            RegisterFogOfWarMaterial (batch.material_);
         }
     }
 }
 
-void FogOfWarManager::UpdateFogOfWarMap ()
+void FogOfWarManager::RegisterFogOfWarMaterial (Urho3D::Material *material)
+{
+    if (material != nullptr && !material->GetShaderParameter ("FogOfWarEnabled").IsEmpty () &&
+            !fogOfWarMaterials_.Contains (Urho3D::SharedPtr <Urho3D::Material> (material)))
+    {
+        fogOfWarMaterials_.Insert (Urho3D::SharedPtr <Urho3D::Material> (material));
+        ApplyMaterialShaderParameters (material);
+    }
+}
+
+void FogOfWarManager::HandleScenePostUpdate (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
 {
-    if (fogOfWarEnabled_)
+    if (nodesToRegisterAgain_.Empty () ||
+            eventData [Urho3D::ScenePostUpdate::P_SCENE].GetPtr () != owner_->GetScene ())
     {
-        DataManager *dataManager = owner_->GetDataManager ();
-        Urho3D::Node *unitsNode = owner_->GetScene ()->GetChild ("units");
-        if (unitsNode == nullptr)
+        return;
+    }
+
+    for (Urho3D::Node *node : nodesToRegisterAgain_)
+    {
+        if (node != nullptr)
         {
-            return;
+            RegisterDrawablesMaterials (node);
         }
+    }
+    nodesToRegisterAgain_.Clear ();
+}
 
-        Urho3D::PODVector <Urho3D::Node *> unitsNodes;
-        unitsNode->GetChildrenWithComponent <Unit> (unitsNodes);
-        fogOfWarMaskImage_->Clear (underFogColor_);
+bool FogOfWarManager::VisionEllipse::operator == (const VisionEllipse &other) const
+{
+    return centerX_ == other.centerX_ && centerY_ == other.centerY_ &&
+            width_ == other.width_ && height_ == other.height_;
+}
 
-        for (const auto &unitNode : unitsNodes)
+bool FogOfWarManager::VisionEllipse::operator != (const VisionEllipse &other) const
+{
+    return !(*this == other);
+}
+
+Urho3D::IntRect FogOfWarManager::VisionEllipse::GetRect () const
+{
+    return Urho3D::IntRect (centerX_ - width_, centerY_ - height_, centerX_ + width_ + 1, centerY_ + height_ + 1);
+}
+
+void FogOfWarManager::UpdateFogOfWarMap ()
+{
+    if (!fogOfWarEnabled_)
+    {
+        return;
+    }
+
+    DataManager *dataManager = owner_->GetDataManager ();
+    Urho3D::Node *unitsNode = owner_->GetScene ()->GetChild ("units");
+    if (unitsNode == nullptr)
+    {
+        return;
+    }
+
+    Urho3D::PODVector <Urho3D::Node *> unitsNodes;
+    unitsNode->GetChildrenWithComponent <Unit> (unitsNodes);
+    currentEllipses_.Clear ();
+
+    for (const auto &unitNode : unitsNodes)
+    {
+        Unit *unit = unitNode->GetComponent <Unit> ();
+        // Disabled units nodes are dead units kept by server in units pool.
+        if (!unitNode->IsEnabled ())
+        {
+            continue;
+        }
+
+        if (owner_->GetPlayerType () == PT_OBSERVER ||
+                (unit->IsBelongsToFirst () && owner_->GetPlayerType () == PT_FIRST) ||
+                (!unit->IsBelongsToFirst () && owner_->GetPlayerType () == PT_SECOND))
         {
-            Unit *unit = unitNode->GetComponent <Unit> ();
-            if (owner_->GetPlayerType () == PT_OBSERVER ||
-                    (unit->IsBelongsToFirst () && owner_->GetPlayerType () == PT_FIRST) ||
-                    (!unit->IsBelongsToFirst () && owner_->GetPlayerType () == PT_SECOND))
+            const UnitType &unitType = dataManager->GetUnitTypeByIndex (unit->GetUnitType ());
+            VisionEllipse ellipse;
+            ellipse.centerX_ = Urho3D::RoundToInt (unit->GetNode ()->GetPosition ().x_ * mapUnitSize_.x_);
+            ellipse.centerY_ = Urho3D::RoundToInt (unit->GetNode ()->GetPosition ().z_ * mapUnitSize_.y_);
+            ellipse.width_ = Urho3D::RoundToInt (unitType.GetVisionRange () * mapUnitSize_.x_);
+            ellipse.height_ = Urho3D::RoundToInt (unitType.GetVisionRange () * mapUnitSize_.y_);
+            currentEllipses_ [unit->GetID ()] = ellipse;
+
+            auto previous = revealedEllipses_.Find (unit->GetID ());
+            if (previous == revealedEllipses_.End ())
             {
-                const UnitType &unitType = dataManager->GetUnitTypeByIndex (unit->GetUnitType ());
-                MakeEllipseVisible (Urho3D::RoundToInt (unit->GetNode ()->GetPosition ().x_ * mapUnitSize_.x_),
-                        Urho3D::RoundToInt (unit->GetNode ()->GetPosition ().z_ * mapUnitSize_.y_),
-                        Urho3D::RoundToInt (unitType.GetVisionRange () * mapUnitSize_.x_),
-                        Urho3D::RoundToInt (unitType.GetVisionRange () * mapUnitSize_.y_));
+                AddDirtyRect (ellipse.GetRect ());
+            }
+            else if (previous->second_ != ellipse)
+            {
+                AddDirtyRect (previous->second_.GetRect ());
+                AddDirtyRect (ellipse.GetRect ());
             }
         }
     }
 
-    fogOfWarMaskTexture_->SetData (fogOfWarMaskImage_);
+    for (const auto &previous : revealedEllipses_)
+    {
+        if (!currentEllipses_.Contains (previous.first_))
+        {
+            AddDirtyRect (previous.second_.GetRect ());
+        }
+    }
+
+    revealedEllipses_.Swap (currentEllipses_);
+    if (fullRedrawRequired_)
+    {
+        dirtyRects_.Clear ();
+        dirtyRects_.Push (Urho3D::IntRect (0, 0, fogOfWarMaskImage_->GetWidth (), fogOfWarMaskImage_->GetHeight ()));
+        fullRedrawRequired_ = false;
+    }
+
+    for (const Urho3D::IntRect &rect : dirtyRects_)
+    {
+        RedrawRect (rect);
+        UploadRect (rect);
+    }
+    dirtyRects_.Clear ();
+}
+
+void FogOfWarManager::AddDirtyRect (Urho3D::IntRect rect)
+{
+    rect.left_ = Urho3D::Max (rect.left_, 0);
+    rect.top_ = Urho3D::Max (rect.top_, 0);
+    rect.right_ = Urho3D::Min (rect.right_, fogOfWarMaskImage_->GetWidth ());
+    rect.bottom_ = Urho3D::Min (rect.bottom_, fogOfWarMaskImage_->GetHeight ());
+
+    if (rect.left_ >= rect.right_ || rect.top_ >= rect.bottom_)
+    {
+        return;
+    }
+
+    // Merged rect can intersect other dirty rects, so merging is repeated until there are no intersections.
+    unsigned int index = 0;
+    while (index < dirtyRects_.Size ())
+    {
+        const Urho3D::IntRect &other = dirtyRects_ [index];
+        if (rect.left_ < other.right_ && other.left_ < rect.right_ &&
+                rect.top_ < other.bottom_ && other.top_ < rect.bottom_)
+        {
+            rect.left_ = Urho3D::Min (rect.left_, other.left_);
+            rect.top_ = Urho3D::Min (rect.top_, other.top_);
+            rect.right_ = Urho3D::Max (rect.right_, other.right_);
+            rect.bottom_ = Urho3D::Max (rect.bottom_, other.bottom_);
+
+            dirtyRects_.EraseSwap (index);
+            index = 0;
+        }
+        else
+        {
+            index++;
+        }
+    }
+    dirtyRects_.Push (rect);
+}
+
+void FogOfWarManager::RedrawRect (const Urho3D::IntRect &rect)
+{
+    unsigned int underFogColor = underFogColor_.ToUInt ();
+    redrawRect_ = rect;
+
+    for (int y = rect.top_; y < rect.bottom_; y++)
+    {
+        FillSpan (rect.left_, rect.right_ - 1, y, underFogColor);
+    }
+
+    for (const auto &ellipse : revealedEllipses_)
+    {
+        Urho3D::IntRect ellipseRect = ellipse.second_.GetRect ();
+        if (ellipseRect.left_ < rect.right_ && rect.left_ < ellipseRect.right_ &&
+                ellipseRect.top_ < rect.bottom_ && rect.top_ < ellipseRect.bottom_)
+        {
+            MakeEllipseVisible (ellipse.second_.centerX_, ellipse.second_.centerY_,
+                    ellipse.second_.width_, ellipse.second_.height_);
+        }
+    }
+}
+
+void FogOfWarManager::UploadRect (const Urho3D::IntRect &rect)
+{
+    const unsigned int pixelSize = 4;
+    unsigned char *maskData = fogOfWarMaskImage_->GetData ();
+    unsigned int maskRowSize = fogOfWarMaskImage_->GetWidth () * pixelSize;
+    unsigned int rectRowSize = rect.Width () * pixelSize;
+
+    // Full width rows are already contiguous in image, otherwise rect rows are packed into upload buffer.
+    const unsigned char *data = maskData + rect.top_ * maskRowSize;
+    if (rectRowSize != maskRowSize)
+    {
+        uploadBuffer_.Resize (rectRowSize * rect.Height ());
+        for (int y = rect.top_; y < rect.bottom_; y++)
+        {
+            memcpy (uploadBuffer_.Buffer () + (y - rect.top_) * rectRowSize,
+                    maskData + y * maskRowSize + rect.left_ * pixelSize, rectRowSize);
+        }
+        data = uploadBuffer_.Buffer ();
+    }
+
+    fogOfWarMaskTexture_->SetData (0, rect.left_, rect.top_, rect.Width (), rect.Height (), data);
 }
 
 void FogOfWarManager::ReleaseImageAndTexture ()
@@ -172,47 +401,77 @@ void FogOfWarManager::ReleaseImageAndTexture ()
     }
 }
 
-void FogOfWarManager::UpdateMaterialsShaderParameters ()
+void FogOfWarManager::ApplyMaterialShaderParameters (Urho3D::Material *material)
 {
-    Urho3D::ResourceCache *resourceCache = context_->GetSubsystem <Urho3D::ResourceCache> ();
-    Urho3D::PODVector <Urho3D::Material *> materials;
-    resourceCache->GetResources <Urho3D::Material> (materials);
+    material->SetShaderParameter ("FogOfWarEnabled", fogOfWarEnabled_ ? 1 : 0);
+    // Mask is not created until map resources are loaded, parameters will be applied after its setup.
+    if (fogOfWarMaskImage_ == nullptr)
+    {
+        return;
+    }
+
+    material->SetShaderParameter ("DefaultColor", underFogColor_);
+    material->SetShaderParameter ("MapMinPoint", Urho3D::Vector3::ZERO);
+    material->SetShaderParameter ("MapMaxPoint", Urho3D::Vector3 (
+            fogOfWarMaskImage_->GetWidth () / mapUnitSize_.x_, 0.0f,
+            fogOfWarMaskImage_->GetHeight () / mapUnitSize_.y_));
+
+    //* Fucking magic of Urho3D shader parameters. Without resetting they can magically become zeros.
+    material->SetShaderParameter ("Unit", material->GetShaderParameter ("Unit").GetInt ());
+    //*
+    material->SetShaderParameter ("MinModifier", underFogColor_.ToVector3 ().Length () * 1.01f);
+    material->SetTexture (Urho3D::TU_ENVIRONMENT, fogOfWarMaskTexture_);
+}
 
-    for (Urho3D::Material *material : materials)
+void FogOfWarManager::UpdateMaterialsShaderParameters ()
+{
+    for (const Urho3D::SharedPtr <Urho3D::Material> &material : fogOfWarMaterials_)
     {
-        if (!material->GetShaderParameter ("FogOfWarEnabled").IsEmpty ())
-        {
-            material->SetShaderParameter ("DefaultColor", underFogColor_);
-            material->SetShaderParameter ("MapMinPoint", Urho3D::Vector3::ZERO);
-            material->SetShaderParameter ("MapMaxPoint", Urho3D::Vector3 (
-                    fogOfWarMaskImage_->GetWidth () / mapUnitSize_.x_, 0.0f,
-                    fogOfWarMaskImage_->GetHeight () / mapUnitSize_.y_));
-
-            //* Fucking magic of Urho3D shader parameters. Without resetting they can magically become zeros.
-            material->SetShaderParameter ("FogOfWarEnabled",
-                    material->GetShaderParameter ("FogOfWarEnabled").GetInt ());
-            material->SetShaderParameter ("Unit", material->GetShaderParameter ("Unit").GetInt ());
-            //*
-            material->SetShaderParameter ("MinModifier", underFogColor_.ToVector3 ().Length () * 1.01f);
-            material->SetTexture (Urho3D::TU_ENVIRONMENT, fogOfWarMaskTexture_);
-        }
+        ApplyMaterialShaderParameters (material);
     }
 }
 
 void FogOfWarManager::ResetText3DMaterials ()
 {
-    Urho3D::PODVector <Urho3D::Text3D *> texts;
-    owner_->GetScene ()->GetComponents <Urho3D::Text3D> (texts, true);
-
-    for (Urho3D::Text3D *text : texts)
+    unsigned int index = 0;
+    while (index < fogOfWarTexts_.Size ())
     {
+        Urho3D::Text3D *text = fogOfWarTexts_ [index];
+        if (text == nullptr)
+        {
+            fogOfWarTexts_.EraseSwap (index);
+            continue;
+        }
+
         // More Urho3D shader magic. Without it Unit and FogOfWarEnabled parameters become zeros in shader.
         text->SetMaterial (text->GetMaterial ());
+        index++;
     }
 }
 
-void FogOfWarManager::MakeEllipseVisible (int centerX, int centerY, int width, int height)
+const Urho3D::PODVector <int> &FogOfWarManager::GetEllipseSpans (int width, int height)
 {
+    unsigned long long key = (static_cast <unsigned long long> (static_cast <unsigned int> (width)) << 32) |
+            static_cast <unsigned int> (height);
+    auto cached = ellipseSpansCache_.Find (key);
+    if (cached != ellipseSpansCache_.End ())
+    {
+        return cached->second_;
+    }
+
+    Urho3D::PODVector <int> &spans = ellipseSpansCache_ [key];
+    spans.Resize (Urho3D::Max (height, 0) + 1);
+    for (int &halfWidth : spans)
+    {
+        halfWidth = width <= 0 || height <= 0 ? Urho3D::Max (width, 0) : -1;
+    }
+
+    // Degenerate ellipse is a line, Bresenham's procedure never ends for it.
+    if (width <= 0 || height <= 0)
+    {
+        return spans;
+    }
+
     // Bresenham's procedure.
     int a2 = width * width;
     int b2 = height * height;
@@ -223,9 +482,7 @@ void FogOfWarManager::MakeEllipseVisible (int centerX, int centerY, int width, i
     // First half.
     for (x = 0, y = height, sigma = 2 * b2 + a2 * (1 - 2 * height); b2 * x <= a2 * y; x++)
     {
-        MakeLineVisible (centerX - x, centerX + x, centerY + y);
-        MakeLineVisible (centerX - x, centerX + x, centerY - y);
-
+        spans [y] = Urho3D::Max (spans [y], x);
         if (sigma >= 0)
         {
             sigma += fa2 * (1 - y);
@@ -238,9 +495,7 @@ void FogOfWarManager::MakeEllipseVisible (int centerX, int centerY, int width, i
     // Second half.
     for (x = width, y = 0, sigma = 2 * a2 + b2 * (1 - 2 * width); a2 * y <= b2 * x; y++)
     {
-        MakeLineVisible (centerX - x, centerX + x, centerY + y);
-        MakeLineVisible (centerX - x, centerX + x, centerY - y);
-
+        spans [y] = Urho3D::Max (spans [y], x);
         if (sigma >= 0)
         {
             sigma += fb2 * (1 - x);
@@ -249,13 +504,45 @@ void FogOfWarManager::MakeEllipseVisible (int centerX, int centerY, int width, i
 
         sigma += a2 * ((4 * y) + 6);
     }
+    return spans;
 }
 
-void FogOfWarManager::MakeLineVisible (int minX, int maxX, int y)
+void FogOfWarManager::MakeEllipseVisible (int centerX, int centerY, int width, int height)
 {
-    for (int x = minX; x <= maxX; x++)
+    const Urho3D::PODVector <int> &spans = GetEllipseSpans (width, height);
+    unsigned int visibleColor = visibleColor_.ToUInt ();
+
+    for (int y = 0; y < static_cast <int> (spans.Size ()); y++)
     {
-        fogOfWarMaskImage_->SetPixel (x, y, visibleColor_);
+        int halfWidth = spans [y];
+        if (halfWidth >= 0)
+        {
+            FillSpan (centerX - halfWidth, centerX + halfWidth, centerY + y, visibleColor);
+            if (y > 0)
+            {
+                FillSpan (centerX - halfWidth, centerX + halfWidth, centerY - y, visibleColor);
+            }
+        }
     }
 }
+
+void FogOfWarManager::FillSpan (int minX, int maxX, int y, unsigned int color)
+{
+    if (y < redrawRect_.top_ || y >= redrawRect_.bottom_)
+    {
+        return;
+    }
+
+    minX = Urho3D::Max (minX, redrawRect_.left_);
+    maxX = Urho3D::Min (maxX, redrawRect_.right_ - 1);
+    if (minX > maxX)
+    {
+        return;
+    }
+
+    // Mask is always RGBA, so each pixel is one packed color. Simple loop is vectorized by compiler.
+    unsigned int *pixels = reinterpret_cast <unsigned int *> (fogOfWarMaskImage_->GetData ()) +
+            y * fogOfWarMaskImage_->GetWidth ();
+    std::fill (pixels + minX, pixels + maxX + 1, color);
+}
 }
@@ -1,6 +1,10 @@
 #pragma once
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Material.h>
 #include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/UI/Text3D.h>
 
 namespace CastlesStrategy
 {
@@ -20,6 +24,10 @@ public:
 
     void SetupFogOfWarMask (const Urho3D::IntVector2 &maskSize, const Urho3D::Vector2 &mapSize);
     void Update (float timeStep);
+    /// Registers materials with fog of war shader parameters, which are used by drawables of node and its children.
+    /// Only registered materials and texts receive fog of war parameters. Node is registered again after next scene
+    /// update, because prefab scripts can assign materials during their first update.
+    void RegisterFogOfWarMaterials (Urho3D::Node *node);
 
     float GetUpdateDelay () const;
     void SetUpdateDelay (float updateDelay);
@@ -35,15 +43,39 @@ public:
     void SetFogOfWarEnabled (bool fogOfWarEnabled);
 
 private:
+    /// Vision ellipse of unit in mask pixels.
+    struct VisionEllipse
+    {
+        bool operator == (const VisionEllipse &other) const;
+        bool operator != (const VisionEllipse &other) const;
+        Urho3D::IntRect GetRect () const;
+
+        int centerX_;
+        int centerY_;
+        int width_;
+        int height_;
+    };
+
+    void RegisterDrawablesMaterials (Urho3D::Node *node);
+    void RegisterFogOfWarMaterial (Urho3D::Material *material);
+    void HandleScenePostUpdate (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+    /// Clears and redraws only regions, where vision ellipses were changed since previous update.
     void UpdateFogOfWarMap ();
+    /// Clips rect to mask and merges it with intersecting dirty rects.
+    void AddDirtyRect (Urho3D::IntRect rect);
+    void RedrawRect (const Urho3D::IntRect &rect);
+    void UploadRect (const Urho3D::IntRect &rect);
     void ReleaseImageAndTexture ();
-    // TODO: It's not a best way, later think about better solutions.
+    void ApplyMaterialShaderParameters (Urho3D::Material *material);
     void UpdateMaterialsShaderParameters ();
-    // TODO: It's not a best way, later think about better solutions.
+    /// Text3D uses copies of its material, so copies must be recreated after material parameters change.
     void ResetText3DMaterials ();
-    /// Bresenham's procedure.
+    /// Returns half widths of ellipse spans for rows from center to top, rasterized by Bresenham's procedure.
+    /// Spans depend only on ellipse size, so they are computed once for each vision range and mask scale.
+    const Urho3D::PODVector <int> &GetEllipseSpans (int width, int height);
     void MakeEllipseVisible (int centerX, int centerY, int width, int height);
-    void MakeLineVisible (int minX, int maxX, int y);
+    /// Fills only part of span, which is inside of current redraw rect, by packed color writes to mask data.
+    void FillSpan (int minX, int maxX, int y, unsigned int color);
 
     IngameActivity *owner_;
     float updateDelay_;
@@ -52,6 +84,22 @@ private:
     Urho3D::Image *fogOfWarMaskImage_;
     Urho3D::SharedPtr <Urho3D::Texture2D> fogOfWarMaskTexture_;
 
+    /// Ellipses drawn on mask during last update by unit id.
+    Urho3D::HashMap <unsigned int, VisionEllipse> revealedEllipses_;
+    Urho3D::HashMap <unsigned int, VisionEllipse> currentEllipses_;
+    Urho3D::PODVector <Urho3D::IntRect> dirtyRects_;
+    Urho3D::IntRect redrawRect_;
+    Urho3D::PODVector <unsigned char> uploadBuffer_;
+    /// Ellipse spans by ellipse width and height packed to one key.
+    Urho3D::HashMap <unsigned long long, Urho3D::PODVector <int> > ellipseSpansCache_;
+    bool fullRedrawRequired_;
+
+    Urho3D::HashSet <Urho3D::SharedPtr <Urho3D::Material> > fogOfWarMaterials_;
+    Urho3D::Vector <Urho3D::WeakPtr <Urho3D::Text3D> > fogOfWarTexts_;
+    Urho3D::Vector <Urho3D::WeakPtr <Urho3D::Node> > nodesToRegisterAgain_;
+    /// Parameters of registered materials are updated only after fog of war settings or mask change.
+    bool materialsParametersDirty_;
+
     Urho3D::Color underFogColor_;
     Urho3D::Color visibleColor_;
     Urho3D::Vector2 mapUnitSize_;
@@ -69,6 +69,7 @@ void IngameActivity::Update (float timeStep)
     cameraManager_->Update (timeStep);
     dataManager_->Update (timeStep);
     fogOfWarManager_->Update (timeStep);
+    networkManager_->Update (timeStep);
 }
 
 void IngameActivity::Stop ()
@@ -295,6 +295,19 @@ void IngameUIManager::InformMapChanged ()
     infoFile->Close ();
 }
 
+void IngameUIManager::InformMapDownloadProgress (const Urho3D::String &mapName, float progress)
+{
+    Urho3D::String percents (Urho3D::FloorToInt (progress * 100.0f));
+    dynamic_cast <Urho3D::Text *> (selectMapWindow_->GetChild ("MapInfoWindow", false)->GetChild ("InfoText", false))->
+            SetText ("Downloading map " + mapName + ": " + percents + "%");
+}
+
+void IngameUIManager::InformMapDownloadFailed (const Urho3D::String &mapName, const Urho3D::String &reason)
+{
+    dynamic_cast <Urho3D::Text *> (selectMapWindow_->GetChild ("MapInfoWindow", false)->GetChild ("InfoText", false))->
+            SetText ("Can not download map " + mapName + ": " + reason + ".");
+}
+
 void IngameUIManager::LoadElements ()
 {
     Urho3D::ResourceCache *resourceCache = context_->GetSubsystem <Urho3D::ResourceCache> ();
@@ -37,6 +37,9 @@ public:
     void UpdatePlayersList ();
     void SwitchToPlayingState ();
     void InformMapChanged ();
+    /// Progress is in [0, 1] range.
+    void InformMapDownloadProgress (const Urho3D::String &mapName, float progress);
+    void InformMapDownloadFailed (const Urho3D::String &mapName, const Urho3D::String &reason);
 
 private:
     struct MessageData
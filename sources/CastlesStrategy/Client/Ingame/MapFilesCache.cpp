@@ -0,0 +1,165 @@
+#include "MapFilesCache.hpp"
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
+
+namespace CastlesStrategy
+{
+MapFilesCache::MapFilesCache (Urho3D::Context *context) : Urho3D::Object (context),
+    cacheFolder_ (DEFAULT_MAP_FILES_CACHE_FOLDER),
+    currentFile_ (),
+    currentFileSize_ (0),
+    currentFileReceived_ (0),
+    currentFileChecksum_ (0),
+    currentFileExpectedChecksum_ (0),
+    decompressionBuffer_ ()
+{
+
+}
+
+MapFilesCache::~MapFilesCache ()
+{
+
+}
+
+bool MapFilesCache::RestoreMapFile (const Urho3D::String &mapName, const Urho3D::String &fileName,
+        unsigned int size, unsigned int checksum)
+{
+    Urho3D::String mapFilePath = GetMapFilePath (mapName, fileName);
+    if (IsFileContentEqual (mapFilePath, size, checksum))
+    {
+        return true;
+    }
+
+    Urho3D::String cachedFilePath = GetCachedFilePath (size, checksum);
+    if (!IsFileContentEqual (cachedFilePath, size, checksum))
+    {
+        return false;
+    }
+
+    Urho3D::FileSystem *fileSystem = context_->GetSubsystem <Urho3D::FileSystem> ();
+    fileSystem->CreateDir (Urho3D::GetPath (mapFilePath));
+    return fileSystem->Copy (cachedFilePath, mapFilePath);
+}
+
+MapFileChunkResult MapFilesCache::BeginMapFile (const Urho3D::String &mapName, const Urho3D::String &fileName,
+        unsigned int size, unsigned int checksum)
+{
+    Urho3D::String path = GetMapFilePath (mapName, fileName);
+    Urho3D::FileSystem *fileSystem = context_->GetSubsystem <Urho3D::FileSystem> ();
+    fileSystem->CreateDir (Urho3D::GetPath (path));
+    fileSystem->Delete (path);
+
+    // Incremental SDBM hash, the same as Urho3D::File::GetChecksum, names cached copy of file.
+    currentFile_ = new Urho3D::File (context_, path, Urho3D::FILE_WRITE);
+    currentFileSize_ = size;
+    currentFileReceived_ = 0;
+    currentFileChecksum_ = 0;
+    currentFileExpectedChecksum_ = checksum;
+
+    if (!currentFile_->IsOpen ())
+    {
+        URHO3D_LOGERROR ("MapFilesCache: can not write file " + path + "!");
+        currentFile_.Reset ();
+        return MFCR_ERROR;
+    }
+    return size == 0 ? FinishMapFile () : MFCR_RECEIVING;
+}
+
+MapFileChunkResult MapFilesCache::WriteCompressedMapFileChunk (const unsigned char *compressedData,
+        unsigned int compressedSize, unsigned int size)
+{
+    if (currentFile_.Null ())
+    {
+        URHO3D_LOGERROR ("MapFilesCache: received chunk, but there is no file to write it!");
+        return MFCR_ERROR;
+    }
+
+    if (size == 0)
+    {
+        return MFCR_RECEIVING;
+    }
+
+    if (currentFileReceived_ + size > currentFileSize_)
+    {
+        URHO3D_LOGERROR ("MapFilesCache: received chunk is out of file " + currentFile_->GetName () + " bounds!");
+        currentFile_.Reset ();
+        return MFCR_ERROR;
+    }
+
+    decompressionBuffer_.Resize (size);
+    if (Urho3D::DecompressData (decompressionBuffer_.Buffer (), compressedData, size) != compressedSize)
+    {
+        URHO3D_LOGERROR ("MapFilesCache: can not decompress chunk of file " + currentFile_->GetName () + "!");
+        currentFile_.Reset ();
+        return MFCR_ERROR;
+    }
+
+    currentFile_->Write (decompressionBuffer_.Buffer (), size);
+    for (unsigned char byte : decompressionBuffer_)
+    {
+        currentFileChecksum_ = Urho3D::SDBMHash (currentFileChecksum_, byte);
+    }
+
+    currentFileReceived_ += size;
+    return currentFileReceived_ == currentFileSize_ ? FinishMapFile () : MFCR_RECEIVING;
+}
+
+const Urho3D::String &MapFilesCache::GetCacheFolder () const
+{
+    return cacheFolder_;
+}
+
+void MapFilesCache::SetCacheFolder (const Urho3D::String &cacheFolder)
+{
+    cacheFolder_ = cacheFolder;
+}
+
+Urho3D::String MapFilesCache::GetMapFilePath (const Urho3D::String &mapName, const Urho3D::String &fileName)
+{
+    return "Data/" + DEFAULT_MAPS_FOLDER + "/" + mapName + "/" + fileName;
+}
+
+Urho3D::String MapFilesCache::GetCachedFilePath (unsigned int size, unsigned int checksum) const
+{
+    return cacheFolder_ + "/" + Urho3D::ToStringHex (checksum) + "_" + Urho3D::String (size);
+}
+
+bool MapFilesCache::IsFileContentEqual (const Urho3D::String &path, unsigned int size, unsigned int checksum) const
+{
+    if (!context_->GetSubsystem <Urho3D::FileSystem> ()->FileExists (path))
+    {
+        return false;
+    }
+
+    Urho3D::File file (context_, path, Urho3D::FILE_READ);
+    return file.IsOpen () && file.GetSize () == size && file.GetChecksum () == checksum;
+}
+
+MapFileChunkResult MapFilesCache::FinishMapFile ()
+{
+    Urho3D::String path = currentFile_->GetName ();
+    currentFile_->Close ();
+    currentFile_.Reset ();
+
+    Urho3D::FileSystem *fileSystem = context_->GetSubsystem <Urho3D::FileSystem> ();
+    if (currentFileChecksum_ != currentFileExpectedChecksum_)
+    {
+        // Broken file must not be used by map loading or restored from cache later.
+        URHO3D_LOGWARNING ("MapFilesCache: checksum of received file " + path + " differs from manifest!");
+        fileSystem->Delete (path);
+        return MFCR_CHECKSUM_MISMATCH;
+    }
+
+    Urho3D::String cachedFilePath = GetCachedFilePath (currentFileSize_, currentFileChecksum_);
+    fileSystem->CreateDir (Urho3D::GetPath (cachedFilePath));
+    fileSystem->Delete (cachedFilePath);
+
+    if (!fileSystem->Copy (path, cachedFilePath))
+    {
+        URHO3D_LOGWARNING ("MapFilesCache: can not copy " + path + " into cache!");
+    }
+    return MFCR_FINISHED;
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/File.h>
+
+namespace CastlesStrategy
+{
+const Urho3D::String DEFAULT_MAP_FILES_CACHE_FOLDER ("MapFilesCache");
+
+enum MapFileChunkResult
+{
+    MFCR_RECEIVING = 0,
+    MFCR_FINISHED,
+    /// Received file is deleted, because its content differs from manifest.
+    MFCR_CHECKSUM_MISMATCH,
+    MFCR_ERROR
+};
+
+/// Stores every received map file by its size and checksum, so files with the same content are not downloaded
+/// again after rejoin, map reselect or from another map.
+class MapFilesCache : public Urho3D::Object
+{
+URHO3D_OBJECT (MapFilesCache, Object)
+public:
+    explicit MapFilesCache (Urho3D::Context *context);
+    virtual ~MapFilesCache ();
+
+    /// Returns true if map file already has given content or it was copied from cache.
+    bool RestoreMapFile (const Urho3D::String &mapName, const Urho3D::String &fileName,
+            unsigned int size, unsigned int checksum);
+    /// Opens map file for writing received chunks. Previous unfinished file is discarded. Empty file is finished
+    /// immediately.
+    MapFileChunkResult BeginMapFile (const Urho3D::String &mapName, const Urho3D::String &fileName,
+            unsigned int size, unsigned int checksum);
+    /// Decompresses chunk into current map file. When file is complete, closes it, verifies its checksum and
+    /// copies it into cache.
+    MapFileChunkResult WriteCompressedMapFileChunk (const unsigned char *compressedData, unsigned int compressedSize,
+            unsigned int size);
+
+    const Urho3D::String &GetCacheFolder () const;
+    void SetCacheFolder (const Urho3D::String &cacheFolder);
+
+    static Urho3D::String GetMapFilePath (const Urho3D::String &mapName, const Urho3D::String &fileName);
+
+private:
+    Urho3D::String GetCachedFilePath (unsigned int size, unsigned int checksum) const;
+    bool IsFileContentEqual (const Urho3D::String &path, unsigned int size, unsigned int checksum) const;
+    MapFileChunkResult FinishMapFile ();
+
+    Urho3D::String cacheFolder_;
+    Urho3D::SharedPtr <Urho3D::File> currentFile_;
+    unsigned int currentFileSize_;
+    unsigned int currentFileReceived_;
+    unsigned int currentFileChecksum_;
+    unsigned int currentFileExpectedChecksum_;
+    Urho3D::PODVector <unsigned char> decompressionBuffer_;
+};
+}
@@ -1,6 +1,5 @@
 #include "NetworkManager.hpp"
 #include <Urho3D/IO/Log.h>
-#include <Urho3D/IO/FileSystem.h>
 
 #include <Urho3D/Network/Network.h>
 #include <Urho3D/Network/NetworkEvents.h>
@@ -24,9 +23,15 @@ void ProcessUnitsPullSyncMessage (IngameActivity *ingameActivity, Urho3D::Vector
 void ProcessCoinsSyncMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData);
 void ProcessChatMessageMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData);
 void ProcessMapFilesMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData);
+void ProcessMapManifestMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData);
 
 NetworkManager::NetworkManager (IngameActivity *owner) : Urho3D::Object (owner->GetContext ()),
     owner_ (owner),
+    trafficStatistics_ ("NetworkManager"),
+    mapFilesCache_ (new MapFilesCache (owner->GetContext ())),
+    downloadingMapName_ (),
+    downloadingFiles_ (),
+    downloadRetries_ (0),
     incomingMessagesProcessors_ (STCNMT_TYPES_COUNT - STCNMT_START)
 {
     SubscribeToEvent (Urho3D::E_NETWORKMESSAGE, URHO3D_HANDLER (NetworkManager, HandleNetworkMessage));
@@ -41,6 +46,7 @@ NetworkManager::NetworkManager (IngameActivity *owner) : Urho3D::Object (owner->
     incomingMessagesProcessors_ [STCNMT_COINS_SYNC - STCNMT_START] = ProcessCoinsSyncMessage;
     incomingMessagesProcessors_ [STCNMT_CHAT_MESSAGE - STCNMT_START] = ProcessChatMessageMessage;
     incomingMessagesProcessors_ [STCNMT_MAP_FILES - STCNMT_START] = ProcessMapFilesMessage;
+    incomingMessagesProcessors_ [STCNMT_MAP_MANIFEST - STCNMT_START] = ProcessMapManifestMessage;
 }
 
 NetworkManager::~NetworkManager ()
@@ -48,32 +54,36 @@ NetworkManager::~NetworkManager ()
     UnsubscribeFromAllEvents ();
 }
 
-void NetworkManager::SendAddOrderMessage (unsigned int unitType) const
+void NetworkManager::Update (float timeStep)
+{
+    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
+    trafficStatistics_.SampleConnection (network->GetServerConnection (), timeStep);
+    trafficStatistics_.Update (timeStep);
+}
+
+void NetworkManager::SendAddOrderMessage (unsigned int unitType)
 {
     Urho3D::VectorBuffer messageData;
     messageData.WriteUInt (unitType);
 
-    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-    network->GetServerConnection ()->SendMessage (CTSNMT_ADD_ORDER, true, true, messageData);
+    SendMessageToServer (CTSNMT_ADD_ORDER, true, true, messageData);
 }
 
-void NetworkManager::SendSpawnMessage (unsigned int spawnID, unsigned int unitType) const
+void NetworkManager::SendSpawnMessage (unsigned int spawnID, unsigned int unitType)
 {
     Urho3D::VectorBuffer messageData;
     messageData.WriteUInt (spawnID);
     messageData.WriteUInt (unitType);
 
-    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-    network->GetServerConnection ()->SendMessage (CTSNMT_SPAWN_UNIT, true, true, messageData);
+    SendMessageToServer (CTSNMT_SPAWN_UNIT, true, true, messageData);
 }
 
-void NetworkManager::SendChatMessage (const Urho3D::String &message) const
+void NetworkManager::SendChatMessage (const Urho3D::String &message)
 {
     Urho3D::VectorBuffer messageData;
     messageData.WriteString (message);
 
-    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-    network->GetServerConnection ()->SendMessage (CTSNMT_CHAT_MESSAGE, true, false, messageData);
+    SendMessageToServer (CTSNMT_CHAT_MESSAGE, true, false, messageData);
 }
 
 void NetworkManager::SendTogglePlayerTypeMessage ()
@@ -84,8 +94,7 @@ void NetworkManager::SendTogglePlayerTypeMessage ()
             PT_REQUESTED_TO_BE_PLAYER : PT_OBSERVER
     );
 
-    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-    network->GetServerConnection ()->SendMessage (CTSNMT_REQUEST_TO_CHANGE_TYPE, true, true, messageData);
+    SendMessageToServer (CTSNMT_REQUEST_TO_CHANGE_TYPE, true, true, messageData);
 }
 
 void NetworkManager::SendToggleReadyMessage ()
@@ -93,8 +102,125 @@ void NetworkManager::SendToggleReadyMessage ()
     Urho3D::VectorBuffer messageData;
     messageData.WriteBool (!owner_->GetDataManager ()->GetPlayers () [owner_->GetPlayerName ()]->readyForStart_);
 
-    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-    network->GetServerConnection ()->SendMessage (CTSNMT_SET_IS_READY_FOR_START, true, true, messageData);
+    SendMessageToServer (CTSNMT_SET_IS_READY_FOR_START, true, true, messageData);
+}
+
+void NetworkManager::SendRequestMapFilesMessage (const Urho3D::String &mapName,
+        const Urho3D::Vector <Urho3D::String> &fileNames)
+{
+    Urho3D::VectorBuffer messageData;
+    messageData.WriteString (mapName);
+    messageData.WriteUInt (fileNames.Size ());
+
+    for (const Urho3D::String &fileName : fileNames)
+    {
+        messageData.WriteString (fileName);
+    }
+    SendMessageToServer (CTSNMT_REQUEST_MAP_FILES, true, true, messageData);
+}
+
+const NetworkTrafficStatistics &NetworkManager::GetTrafficStatistics () const
+{
+    return trafficStatistics_;
+}
+
+MapFilesCache *NetworkManager::GetMapFilesCache () const
+{
+    return mapFilesCache_;
+}
+
+const Urho3D::String &NetworkManager::GetDownloadingMapName () const
+{
+    return downloadingMapName_;
+}
+
+void NetworkManager::StartMapDownload (const Urho3D::String &mapName,
+        const Urho3D::HashMap <Urho3D::String, unsigned int> &filesChecksums)
+{
+    downloadingFiles_ = filesChecksums;
+    downloadRetries_ = 0;
+    if (downloadingFiles_.Empty ())
+    {
+        downloadingMapName_ = Urho3D::String::EMPTY;
+        owner_->GetDataManager ()->SetMapName (mapName);
+    }
+    else
+    {
+        // Map info is read from map files, so map is selected only after all missing files are received.
+        downloadingMapName_ = mapName;
+        owner_->GetIngameUIManager ()->InformMapDownloadProgress (mapName, 0.0f);
+        RequestDownloadingFiles ();
+    }
+}
+
+bool NetworkManager::IsMapFileDownloading (const Urho3D::String &mapName, const Urho3D::String &fileName) const
+{
+    return !downloadingMapName_.Empty () && mapName == downloadingMapName_ && downloadingFiles_.Contains (fileName);
+}
+
+unsigned int NetworkManager::GetDownloadingFileChecksum (const Urho3D::String &fileName) const
+{
+    auto iterator = downloadingFiles_.Find (fileName);
+    return iterator != downloadingFiles_.End () ? iterator->second_ : 0;
+}
+
+void NetworkManager::ProcessMapFileChunkResult (const Urho3D::String &fileName, MapFileChunkResult result)
+{
+    if (result == MFCR_FINISHED)
+    {
+        downloadingFiles_.Erase (fileName);
+        if (downloadingFiles_.Empty ())
+        {
+            Urho3D::String mapName = downloadingMapName_;
+            downloadingMapName_ = Urho3D::String::EMPTY;
+            owner_->GetDataManager ()->SetMapName (mapName);
+        }
+    }
+    else if (result == MFCR_CHECKSUM_MISMATCH)
+    {
+        if (downloadRetries_ >= DEFAULT_MAP_FILES_MAX_DOWNLOAD_RETRIES)
+        {
+            AbortMapDownload ("file " + fileName + " is broken");
+        }
+        else
+        {
+            // New request replaces unfinished transfer on server, so all files, that are not received yet,
+            // are requested again.
+            URHO3D_LOGWARNING ("NetworkManager: map file " + fileName + " is broken, requesting it again.");
+            downloadRetries_++;
+            RequestDownloadingFiles ();
+        }
+    }
+    else if (result == MFCR_ERROR)
+    {
+        AbortMapDownload ("can not write file " + fileName);
+    }
+}
+
+void NetworkManager::SendMessageToServer (int messageType, bool reliable, bool inOrder,
+        const Urho3D::VectorBuffer &messageData)
+{
+    Urho3D::Connection *serverConnection = context_->GetSubsystem <Urho3D::Network> ()->GetServerConnection ();
+    trafficStatistics_.RecordSent (serverConnection, messageType, messageData.GetSize ());
+    serverConnection->SendMessage (messageType, reliable, inOrder, messageData);
+}
+
+void NetworkManager::RequestDownloadingFiles ()
+{
+    Urho3D::Vector <Urho3D::String> fileNames;
+    for (const auto &file : downloadingFiles_)
+    {
+        fileNames.Push (file.first_);
+    }
+    SendRequestMapFilesMessage (downloadingMapName_, fileNames);
+}
+
+void NetworkManager::AbortMapDownload (const Urho3D::String &reason)
+{
+    URHO3D_LOGERROR ("NetworkManager: download of map " + downloadingMapName_ + " is aborted, " + reason + "!");
+    owner_->GetIngameUIManager ()->InformMapDownloadFailed (downloadingMapName_, reason);
+    downloadingMapName_ = Urho3D::String::EMPTY;
+    downloadingFiles_.Clear ();
 }
 
 void NetworkManager::HandleNetworkMessage (Urho3D::StringHash eventType, Urho3D::VariantMap &data)
@@ -103,6 +229,9 @@ void NetworkManager::HandleNetworkMessage (Urho3D::StringHash eventType, Urho3D:
     if (messageID >= STCNMT_START && messageID < STCNMT_TYPES_COUNT)
     {
         Urho3D::VectorBuffer messageData = data[Urho3D::NetworkMessage::P_DATA].GetVectorBuffer ();
+        trafficStatistics_.RecordReceived (
+                dynamic_cast <Urho3D::Connection *> (data [Urho3D::NetworkMessage::P_CONNECTION].GetPtr ()),
+                messageID, messageData.GetSize ());
         incomingMessagesProcessors_[messageID - STCNMT_START] (owner_, messageData);
     }
 }
@@ -152,7 +281,13 @@ void ProcessPlayerLeftMessage (IngameActivity *ingameActivity, Urho3D::VectorBuf
 
 void ProcessObjectSpawnedMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData)
 {
-    ingameActivity->GetDataManager ()->AddPrefabToObject (messageData.ReadUInt ());
+    unsigned int count = messageData.ReadUInt ();
+    Urho3D::PODVector <unsigned int> nodesIDs (count);
+    for (unsigned int index = 0; index < count; index++)
+    {
+        nodesIDs [index] = messageData.ReadUInt ();
+    }
+    ingameActivity->GetDataManager ()->AddPrefabToObjects (nodesIDs);
 }
 
 void ProcessUnitsPullSyncMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData)
@@ -173,25 +308,72 @@ void ProcessChatMessageMessage (IngameActivity *ingameActivity, Urho3D::VectorBu
 }
 
 void ProcessMapFilesMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData)
+{
+    Urho3D::String mapName = messageData.ReadString ();
+    unsigned int transferSize = messageData.ReadUInt ();
+    unsigned int transferOffset = messageData.ReadUInt ();
+    Urho3D::String fileName = messageData.ReadString ();
+    unsigned int fileSize = messageData.ReadUInt ();
+    unsigned int fileOffset = messageData.ReadUInt ();
+    unsigned int size = messageData.ReadUInt ();
+    unsigned int compressedSize = messageData.ReadUInt ();
+
+    // Chunks of previous transfer can be received after repeated request, already received files are skipped.
+    NetworkManager *networkManager = ingameActivity->GetNetworkManager ();
+    if (!networkManager->IsMapFileDownloading (mapName, fileName))
+    {
+        return;
+    }
+
+    if (compressedSize > messageData.GetSize () - messageData.GetPosition ())
+    {
+        URHO3D_LOGERROR ("NetworkManager: received broken chunk of map file " + fileName + "!");
+        networkManager->ProcessMapFileChunkResult (fileName, MFCR_ERROR);
+        return;
+    }
+
+    MapFilesCache *mapFilesCache = networkManager->GetMapFilesCache ();
+    MapFileChunkResult result = MFCR_RECEIVING;
+    if (fileOffset == 0)
+    {
+        result = mapFilesCache->BeginMapFile (mapName, fileName, fileSize,
+                networkManager->GetDownloadingFileChecksum (fileName));
+    }
+
+    if (result == MFCR_RECEIVING)
+    {
+        const unsigned char *compressedData = messageData.GetData () + messageData.GetPosition ();
+        result = mapFilesCache->WriteCompressedMapFileChunk (compressedData, compressedSize, size);
+    }
+
+    networkManager->ProcessMapFileChunkResult (fileName, result);
+    if (!networkManager->GetDownloadingMapName ().Empty () && transferSize > 0)
+    {
+        ingameActivity->GetIngameUIManager ()->InformMapDownloadProgress (
+                mapName, 1.0f * (transferOffset + size) / transferSize);
+    }
+}
+
+void ProcessMapManifestMessage (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData)
 {
     Urho3D::String mapName = messageData.ReadString ();
     unsigned int filesCount = messageData.ReadUInt ();
-    ingameActivity->GetDataManager ()->SetMapName (mapName);
+
+    MapFilesCache *mapFilesCache = ingameActivity->GetNetworkManager ()->GetMapFilesCache ();
+    Urho3D::HashMap <Urho3D::String, unsigned int> missingFiles;
 
     while (filesCount > 0)
     {
         Urho3D::String fileName = messageData.ReadString ();
-        Urho3D::PODVector <unsigned char> fileContent = messageData.ReadBuffer ();
-
-        Urho3D::String fullPath = "Data/" + DEFAULT_MAPS_FOLDER + "/" + mapName + "/" + fileName;
-        Urho3D::FileSystem *fileSystem = ingameActivity->GetContext ()->GetSubsystem <Urho3D::FileSystem> ();
-        fileSystem->CreateDir (fullPath.Substring (0, fullPath.FindLast ('/')));
-        fileSystem->Delete (fullPath);
+        unsigned int size = messageData.ReadUInt ();
+        unsigned int checksum = messageData.ReadUInt ();
 
-        Urho3D::File *file = new Urho3D::File (ingameActivity->GetContext (), fullPath, Urho3D::FILE_WRITE);
-        file->Write (&fileContent [0], fileContent.Size ());
-        file->Close ();
+        if (!mapFilesCache->RestoreMapFile (mapName, fileName, size, checksum))
+        {
+            missingFiles [fileName] = checksum;
+        }
         filesCount--;
     }
+    ingameActivity->GetNetworkManager ()->StartMapDownload (mapName, missingFiles);
 }
 }
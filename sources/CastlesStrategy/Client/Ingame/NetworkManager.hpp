@@ -1,8 +1,14 @@
 #pragma once
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Container/HashMap.h>
+#include <CastlesStrategy/Client/Ingame/MapFilesCache.hpp>
+#include <CastlesStrategy/Shared/Network/NetworkTrafficStatistics.hpp>
 
 namespace CastlesStrategy
 {
+/// Map download is aborted if received files are still broken after this count of requests.
+const unsigned int DEFAULT_MAP_FILES_MAX_DOWNLOAD_RETRIES = 3;
+
 class IngameActivity;
 typedef void (*ClientIncomingNetworkMessageProcessor) (IngameActivity *ingameActivity, Urho3D::VectorBuffer &messageData);
 
@@ -12,18 +18,42 @@ URHO3D_OBJECT (NetworkManager, Object)
 public:
     explicit NetworkManager (IngameActivity *owner);
     virtual ~NetworkManager ();
+    void Update (float timeStep);
 
-    void SendAddOrderMessage (unsigned int unitType) const;
-    void SendSpawnMessage (unsigned int spawnID, unsigned int unitType) const;
-    void SendChatMessage (const Urho3D::String &message) const;
+    void SendAddOrderMessage (unsigned int unitType);
+    void SendSpawnMessage (unsigned int spawnID, unsigned int unitType);
+    void SendChatMessage (const Urho3D::String &message);
 
     void SendTogglePlayerTypeMessage ();
     void SendToggleReadyMessage ();
+    void SendRequestMapFilesMessage (const Urho3D::String &mapName, const Urho3D::Vector <Urho3D::String> &fileNames);
+
+    const NetworkTrafficStatistics &GetTrafficStatistics () const;
+    MapFilesCache *GetMapFilesCache () const;
+    /// Name of map which files are being received now or empty string if there is no active download.
+    const Urho3D::String &GetDownloadingMapName () const;
+    /// Requests given files with their manifest checksums. Map is selected when all files are received.
+    void StartMapDownload (const Urho3D::String &mapName,
+            const Urho3D::HashMap <Urho3D::String, unsigned int> &filesChecksums);
+    bool IsMapFileDownloading (const Urho3D::String &mapName, const Urho3D::String &fileName) const;
+    /// Returns manifest checksum of file, which is being downloaded.
+    unsigned int GetDownloadingFileChecksum (const Urho3D::String &fileName) const;
+    /// Processes result of file chunk: broken files are requested again, on error download is aborted.
+    void ProcessMapFileChunkResult (const Urho3D::String &fileName, MapFileChunkResult result);
 
 private:
+    void SendMessageToServer (int messageType, bool reliable, bool inOrder, const Urho3D::VectorBuffer &messageData);
     void HandleNetworkMessage (Urho3D::StringHash eventType, Urho3D::VariantMap &data);
+    void RequestDownloadingFiles ();
+    void AbortMapDownload (const Urho3D::String &reason);
 
     IngameActivity *owner_;
+    NetworkTrafficStatistics trafficStatistics_;
+    Urho3D::SharedPtr <MapFilesCache> mapFilesCache_;
+    Urho3D::String downloadingMapName_;
+    /// Manifest checksums of files, which are not received yet, by file name.
+    Urho3D::HashMap <Urho3D::String, unsigned int> downloadingFiles_;
+    unsigned int downloadRetries_;
     Urho3D::PODVector <ClientIncomingNetworkMessageProcessor> incomingMessagesProcessors_;
 };
 }
@@ -0,0 +1,220 @@
+#include "UnitMotionInterpolator.hpp"
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Scene/Node.h>
+#include <Utils/UniversalException.hpp>
+
+namespace CastlesStrategy
+{
+UnitMotionInterpolator::UnitMotionInterpolator (Urho3D::Context *context) : Urho3D::LogicComponent (context),
+    interpolationDelay_ (DEFAULT_MOTION_INTERPOLATION_DELAY),
+    maxExtrapolationTime_ (DEFAULT_MOTION_MAX_EXTRAPOLATION_TIME),
+    teleportDistance_ (DEFAULT_MOTION_TELEPORT_DISTANCE),
+    elapsedTime_ (0.0f),
+    snapshotsInterval_ (DEFAULT_MOTION_SNAPSHOTS_INTERVAL),
+    snapshots_ (),
+
+    offsetPosition_ (Urho3D::Vector3::ZERO),
+    offsetRotation_ (Urho3D::Quaternion::IDENTITY)
+{
+    SetUpdateEventMask (Urho3D::USE_UPDATE);
+}
+
+UnitMotionInterpolator::~UnitMotionInterpolator ()
+{
+
+}
+
+void UnitMotionInterpolator::RegisterObject (Urho3D::Context *context)
+{
+    context->RegisterFactory <UnitMotionInterpolator> ("Logic");
+    URHO3D_ACCESSOR_ATTRIBUTE ("Is Enabled", IsEnabled, SetEnabled, bool, true, Urho3D::AM_DEFAULT);
+
+    URHO3D_ACCESSOR_ATTRIBUTE ("Interpolation Delay", GetInterpolationDelay, SetInterpolationDelay,
+            float, DEFAULT_MOTION_INTERPOLATION_DELAY, Urho3D::AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE ("Max Extrapolation Time", GetMaxExtrapolationTime, SetMaxExtrapolationTime,
+            float, DEFAULT_MOTION_MAX_EXTRAPOLATION_TIME, Urho3D::AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE ("Teleport Distance", GetTeleportDistance, SetTeleportDistance,
+            float, DEFAULT_MOTION_TELEPORT_DISTANCE, Urho3D::AM_DEFAULT);
+}
+
+void UnitMotionInterpolator::DelayedStart ()
+{
+    offsetPosition_ = node_->GetPosition ();
+    offsetRotation_ = node_->GetRotation ();
+}
+
+void UnitMotionInterpolator::Update (float timeStep)
+{
+    Urho3D::Node *unitNode = node_->GetParent ();
+    if (unitNode == nullptr)
+    {
+        return;
+    }
+
+    elapsedTime_ += timeStep;
+    RecordSnapshot (unitNode->GetWorldPosition (), unitNode->GetWorldRotation ());
+
+    float renderTime = elapsedTime_ - interpolationDelay_;
+    RemoveOutdatedSnapshots (renderTime);
+
+    Urho3D::Vector3 position;
+    Urho3D::Quaternion rotation;
+    SampleSnapshots (renderTime, position, rotation);
+
+    node_->SetWorldPosition (position + rotation * offsetPosition_);
+    node_->SetWorldRotation (rotation * offsetRotation_);
+}
+
+void UnitMotionInterpolator::OnSetEnabled ()
+{
+    Urho3D::LogicComponent::OnSetEnabled ();
+    // Pooled unit nodes are disabled and then enabled at another spawn, old snapshots must not be interpolated.
+    if (!IsEnabledEffective ())
+    {
+        snapshots_.Clear ();
+    }
+}
+
+float UnitMotionInterpolator::GetInterpolationDelay () const
+{
+    return interpolationDelay_;
+}
+
+void UnitMotionInterpolator::SetInterpolationDelay (float interpolationDelay)
+{
+    if (interpolationDelay < 0.0f)
+    {
+        throw UniversalException <UnitMotionInterpolator> (
+                "UnitMotionInterpolator: interpolation delay can not be less than 0!");
+    }
+    interpolationDelay_ = interpolationDelay;
+}
+
+float UnitMotionInterpolator::GetMaxExtrapolationTime () const
+{
+    return maxExtrapolationTime_;
+}
+
+void UnitMotionInterpolator::SetMaxExtrapolationTime (float maxExtrapolationTime)
+{
+    if (maxExtrapolationTime < 0.0f)
+    {
+        throw UniversalException <UnitMotionInterpolator> (
+                "UnitMotionInterpolator: max extrapolation time can not be less than 0!");
+    }
+    maxExtrapolationTime_ = maxExtrapolationTime;
+}
+
+float UnitMotionInterpolator::GetTeleportDistance () const
+{
+    return teleportDistance_;
+}
+
+void UnitMotionInterpolator::SetTeleportDistance (float teleportDistance)
+{
+    if (teleportDistance < 0.0f)
+    {
+        throw UniversalException <UnitMotionInterpolator> (
+                "UnitMotionInterpolator: teleport distance can not be less than 0!");
+    }
+    teleportDistance_ = teleportDistance;
+}
+
+void UnitMotionInterpolator::RecordSnapshot (const Urho3D::Vector3 &position, const Urho3D::Quaternion &rotation)
+{
+    // Position of respawned unit can be replicated after its enabled flag, so teleport is detected by distance too.
+    if (!snapshots_.Empty () && (position - snapshots_.Back ().position_).Length () > teleportDistance_)
+    {
+        snapshots_.Clear ();
+    }
+
+    if (snapshots_.Empty ())
+    {
+        snapshots_.Push ({elapsedTime_, position, rotation});
+        return;
+    }
+
+    MotionSnapshot newest = snapshots_.Back ();
+    float interval = elapsedTime_ - newest.time_;
+    // Server does not send transform of standing unit, so long pause means that unit stood at newest position
+    // since next expected update. Without this snapshot motion after pause would be stretched over whole pause.
+    bool isPause = interval > 2.0f * snapshotsInterval_;
+
+    if (position == newest.position_ && rotation == newest.rotation_)
+    {
+        bool isPauseRecorded = snapshots_.Size () > 1 &&
+                snapshots_ [snapshots_.Size () - 2].position_ == newest.position_ &&
+                snapshots_ [snapshots_.Size () - 2].rotation_ == newest.rotation_;
+
+        if (isPause && !isPauseRecorded)
+        {
+            snapshots_.Push ({newest.time_ + snapshotsInterval_, newest.position_, newest.rotation_});
+        }
+        return;
+    }
+
+    if (isPause)
+    {
+        snapshots_.Push ({elapsedTime_ - snapshotsInterval_, newest.position_, newest.rotation_});
+    }
+    else
+    {
+        snapshotsInterval_ = Urho3D::Lerp (snapshotsInterval_, interval, 0.1f);
+    }
+
+    snapshots_.Push ({elapsedTime_, position, rotation});
+    if (snapshots_.Size () > DEFAULT_MOTION_MAX_SNAPSHOTS)
+    {
+        snapshots_.Erase (0, snapshots_.Size () - DEFAULT_MOTION_MAX_SNAPSHOTS);
+    }
+}
+
+void UnitMotionInterpolator::RemoveOutdatedSnapshots (float renderTime)
+{
+    // Two snapshots before render time are kept for extrapolation.
+    unsigned int outdatedCount = 0;
+    while (outdatedCount + 2 < snapshots_.Size () && snapshots_ [outdatedCount + 1].time_ <= renderTime)
+    {
+        outdatedCount++;
+    }
+
+    if (outdatedCount > 0)
+    {
+        snapshots_.Erase (0, outdatedCount);
+    }
+}
+
+void UnitMotionInterpolator::SampleSnapshots (float renderTime,
+        Urho3D::Vector3 &position, Urho3D::Quaternion &rotation) const
+{
+    const MotionSnapshot &oldest = snapshots_.Front ();
+    if (snapshots_.Size () == 1 || renderTime <= oldest.time_)
+    {
+        position = oldest.position_;
+        rotation = oldest.rotation_;
+        return;
+    }
+
+    for (unsigned int index = 0; index + 1 < snapshots_.Size (); index++)
+    {
+        const MotionSnapshot &from = snapshots_ [index];
+        const MotionSnapshot &to = snapshots_ [index + 1];
+
+        if (renderTime < to.time_)
+        {
+            float factor = (renderTime - from.time_) / (to.time_ - from.time_);
+            position = from.position_.Lerp (to.position_, factor);
+            rotation = from.rotation_.Slerp (to.rotation_, factor);
+            return;
+        }
+    }
+
+    const MotionSnapshot &previous = snapshots_ [snapshots_.Size () - 2];
+    const MotionSnapshot &newest = snapshots_.Back ();
+    float extrapolationTime = Urho3D::Min (renderTime - newest.time_, maxExtrapolationTime_);
+    Urho3D::Vector3 velocity = (newest.position_ - previous.position_) / (newest.time_ - previous.time_);
+
+    position = newest.position_ + velocity * extrapolationTime;
+    rotation = newest.rotation_;
+}
+}
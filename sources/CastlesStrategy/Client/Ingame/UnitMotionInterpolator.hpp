@@ -0,0 +1,65 @@
+#pragma once
+#include <Urho3D/Scene/LogicComponent.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Quaternion.h>
+#include <Urho3D/Math/Vector3.h>
+
+namespace CastlesStrategy
+{
+const float DEFAULT_MOTION_INTERPOLATION_DELAY = 0.1f;
+const float DEFAULT_MOTION_MAX_EXTRAPOLATION_TIME = 0.1f;
+const unsigned int DEFAULT_MOTION_MAX_SNAPSHOTS = 16;
+/// Pooled units are respawned by server far from their previous position, such jumps are not interpolated.
+const float DEFAULT_MOTION_TELEPORT_DISTANCE = 5.0f;
+/// Expected interval between replicated transforms until real interval is measured. Equals Urho3D default network FPS.
+const float DEFAULT_MOTION_SNAPSHOTS_INTERVAL = 1.0f / 30.0f;
+
+/// Client side component for local prefab node of replicated unit. Records parent node transforms, received from
+/// server, with client time and places prefab at interpolated transform with given delay. If next transform is
+/// late, motion is extrapolated, but not further than max extrapolation time.
+class UnitMotionInterpolator : public Urho3D::LogicComponent
+{
+URHO3D_OBJECT (UnitMotionInterpolator, LogicComponent)
+public:
+    explicit UnitMotionInterpolator (Urho3D::Context *context);
+    virtual ~UnitMotionInterpolator ();
+
+    static void RegisterObject (Urho3D::Context *context);
+    virtual void DelayedStart ();
+    virtual void Update (float timeStep);
+    virtual void OnSetEnabled ();
+
+    float GetInterpolationDelay () const;
+    void SetInterpolationDelay (float interpolationDelay);
+
+    float GetMaxExtrapolationTime () const;
+    void SetMaxExtrapolationTime (float maxExtrapolationTime);
+
+    float GetTeleportDistance () const;
+    void SetTeleportDistance (float teleportDistance);
+
+private:
+    struct MotionSnapshot
+    {
+        float time_;
+        Urho3D::Vector3 position_;
+        Urho3D::Quaternion rotation_;
+    };
+
+    void RecordSnapshot (const Urho3D::Vector3 &position, const Urho3D::Quaternion &rotation);
+    void RemoveOutdatedSnapshots (float renderTime);
+    void SampleSnapshots (float renderTime, Urho3D::Vector3 &position, Urho3D::Quaternion &rotation) const;
+
+    float interpolationDelay_;
+    float maxExtrapolationTime_;
+    float teleportDistance_;
+    float elapsedTime_;
+    /// Smoothed interval between replicated transforms, used to detect that unit stopped.
+    float snapshotsInterval_;
+    Urho3D::PODVector <MotionSnapshot> snapshots_;
+
+    /// Prefab local transform, relative to unit node.
+    Urho3D::Vector3 offsetPosition_;
+    Urho3D::Quaternion offsetRotation_;
+};
+}
@@ -4,9 +4,7 @@
 #include <Urho3D/Network/Network.h>
 
 #include <CastlesStrategy/Server/Activity/ServerActivity.hpp>
-#include <CastlesStrategy/Server/Managers/PlayersManager.hpp>
-#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
-#include <CastlesStrategy/Server/Player/Player.hpp>
+#include <CastlesStrategy/Server/Replay/MatchInput.hpp>
 
 #include <CastlesStrategy/Shared/Network/ServerToClientNetworkMessageType.hpp>
 #include <Utils/UniversalException.hpp>
@@ -19,14 +17,12 @@ void AddOrder (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urho
 {
     if (sender == activity->GetFirstPlayer () || sender == activity->GetSecondPlayer ())
     {
-        PlayersManager *playersManager = dynamic_cast <PlayersManager *> (
-                activity->GetManagersHub ()->GetManager (MI_PLAYERS_MANAGER));
-
-        Player &player = sender == activity->GetFirstPlayer () ?
-                playersManager->GetFirstPlayer () : playersManager->GetSecondPlayer ();
-
-        unsigned int unitType = messageData.ReadUInt ();
-        player.AddOrder (unitType);
+        MatchInput input;
+        input.type_ = MIT_ADD_ORDER;
+        input.firstPlayer_ = sender == activity->GetFirstPlayer ();
+        input.unitType_ = messageData.ReadUInt ();
+        input.spawnId_ = 0;
+        activity->ApplyPlayerInput (input);
     }
 }
 
@@ -34,19 +30,12 @@ void SpawnUnit (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urh
 {
     if (sender == activity->GetFirstPlayer () || sender == activity->GetSecondPlayer ())
     {
-        unsigned int spawnID = messageData.ReadUInt ();
-        unsigned int unitType = messageData.ReadUInt ();
-
-        PlayersManager *playersManager = dynamic_cast <PlayersManager *> (
-                activity->GetManagersHub ()->GetManager (MI_PLAYERS_MANAGER));
-
-        Player &player = sender == activity->GetFirstPlayer () ?
-                playersManager->GetFirstPlayer () : playersManager->GetSecondPlayer ();
-        player.TakeUnitFromPull (unitType);
-
-        UnitsManager *unitsManager = dynamic_cast <UnitsManager *> (
-                activity->GetManagersHub ()->GetManager (MI_UNITS_MANAGER));
-        unitsManager->SpawnUnit (spawnID, unitType);
+        MatchInput input;
+        input.type_ = MIT_SPAWN_UNIT;
+        input.firstPlayer_ = sender == activity->GetFirstPlayer ();
+        input.spawnId_ = messageData.ReadUInt ();
+        input.unitType_ = messageData.ReadUInt ();
+        activity->ApplyPlayerInput (input);
     }
 }
 
@@ -78,7 +67,7 @@ void ChatMessage (ServerActivity *activity, Urho3D::VectorBuffer &messageData, U
 
     for (const auto &item : activity->GetIdentifiedConnections ())
     {
-        item.second_.connection_->SendMessage (STCNMT_CHAT_MESSAGE, true, false, newMessageData);
+        activity->SendNetworkMessage (item.second_.connection_, STCNMT_CHAT_MESSAGE, true, false, newMessageData);
     }
 }
 
@@ -91,5 +80,19 @@ void SetIsReadyForStart (ServerActivity *activity, Urho3D::VectorBuffer &message
 {
     activity->SetIsPlayerReady (sender, messageData.ReadBool ());
 }
+
+void RequestMapFiles (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urho3D::Connection *sender)
+{
+    Urho3D::String mapName = messageData.ReadString ();
+    unsigned int filesCount = messageData.ReadUInt ();
+    Urho3D::Vector <Urho3D::String> fileNames;
+
+    while (filesCount > 0 && !messageData.IsEof ())
+    {
+        fileNames.Push (messageData.ReadString ());
+        filesCount--;
+    }
+    activity->SendMapFiles (sender, mapName, fileNames);
+}
 }
 }
@@ -14,5 +14,6 @@ void ChatMessage (ServerActivity *activity, Urho3D::VectorBuffer &messageData, U
 
 void RequestToChangeType (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urho3D::Connection *sender);
 void SetIsReadyForStart (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urho3D::Connection *sender);
+void RequestMapFiles (ServerActivity *activity, Urho3D::VectorBuffer &messageData, Urho3D::Connection *sender);
 }
 }
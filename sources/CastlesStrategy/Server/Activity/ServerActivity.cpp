@@ -1,9 +1,11 @@
 #include "ServerActivity.hpp"
 #include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Network/NetworkEvents.h>
 #include <Urho3D/Network/Network.h>
 
+#include <Urho3D/Resource/JSONFile.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Resource/XMLFile.h>
 #include <Urho3D/Scene/SceneEvents.h>
@@ -11,6 +13,7 @@
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/IO/File.h>
+#include <Urho3D/IO/Compression.h>
 
 #include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
 #include <CastlesStrategy/Server/Managers/PlayersManager.hpp>
@@ -30,6 +33,23 @@ namespace CastlesStrategy
 ServerActivity::ServerActivity (Urho3D::Context *context) : Activity (context),
     autoDisconnectTime_ (DEFAULT_AUTO_DISCONNECT_TIME),
     serverPort_ (DEFAULT_SERVER_PORT),
+    simulationRate_ (DEFAULT_SIMULATION_RATE),
+    maxCatchUpTicks_ (DEFAULT_MAX_SIMULATION_CATCH_UP_TICKS),
+    simulationAccumulator_ (0.0f),
+    simulationTick_ (0),
+    autoStartWhenReady_ (false),
+    statisticsExportPath_ (DEFAULT_STATISTICS_EXPORT_PATH),
+    statisticsExportInterval_ (DEFAULT_STATISTICS_EXPORT_INTERVAL),
+    untilStatisticsExport_ (DEFAULT_STATISTICS_EXPORT_INTERVAL),
+    trafficStatistics_ ("ServerActivity"),
+    interestManagementEnabled_ (true),
+    firstPlayerInterestFilter_ (),
+    secondPlayerInterestFilter_ (),
+
+    matchRecordingPath_ (),
+    matchRecording_ (),
+    isRecordingMatch_ (false),
+    replayPath_ (),
 
     currentGameStatus_ (GS_WAITING),
     unidentifiedConnections_ (),
@@ -38,7 +58,11 @@ ServerActivity::ServerActivity (Urho3D::Context *context) : Activity (context),
     managersHub_ (nullptr),
     scene_ (new Urho3D::Scene (context_)),
     mapName_ (),
-    mapData_ (),
+    mapManifest_ (),
+    mapFiles_ (),
+    mapFilesTransfers_ (),
+    compressionBuffer_ (),
+    spawnedObjectsIDs_ (),
 
     incomingNetworkMessageProcessors_ (CTSNMT_TYPES_COUNT - CTSNMT_START),
     countOfPlayers_ (0),
@@ -56,6 +80,9 @@ ServerActivity::ServerActivity (Urho3D::Context *context) : Activity (context),
     incomingNetworkMessageProcessors_ [CTSNMT_SET_IS_READY_FOR_START - CTSNMT_START] =
             IncomingNetworkMessageProcessors::SetIsReadyForStart;
 
+    incomingNetworkMessageProcessors_ [CTSNMT_REQUEST_MAP_FILES - CTSNMT_START] =
+            IncomingNetworkMessageProcessors::RequestMapFiles;
+
     SubscribeToEvent (Urho3D::E_CLIENTCONNECTED, URHO3D_HANDLER (ServerActivity, HandleClientConnected));
     SubscribeToEvent (Urho3D::E_CLIENTIDENTITY, URHO3D_HANDLER (ServerActivity, HandleClientIdentity));
     SubscribeToEvent (Urho3D::E_CLIENTDISCONNECTED, URHO3D_HANDLER (ServerActivity, HandleClientDisconnected));
@@ -84,6 +111,12 @@ ServerActivity::~ServerActivity ()
 
 void ServerActivity::Start ()
 {
+    if (!replayPath_.Empty ())
+    {
+        RunReplay ();
+        return;
+    }
+
     Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
     network->StartServer (serverPort_);
 }
@@ -91,14 +124,34 @@ void ServerActivity::Start ()
 void ServerActivity::Update (float timeStep)
 {
     ProcessUnidentifiedConnections (timeStep);
+    for (auto &connectionData : identifiedConnections_)
+    {
+        trafficStatistics_.SampleConnection (connectionData.second_.connection_, timeStep);
+    }
+    trafficStatistics_.Update (timeStep);
+    UpdateMapFilesTransfers ();
+
     if (managersHub_ != nullptr && currentGameStatus_ == GS_PLAYING)
     {
-        managersHub_->HandleUpdate (timeStep);
+        UpdateSimulation (timeStep);
+        UpdateUnitsInterest ();
+        UpdateStatisticsExport (timeStep);
+    }
+    SendSpawnedObjects ();
+
+    if (isRecordingMatch_ && currentGameStatus_ != GS_PLAYING)
+    {
+        SaveMatchRecording ();
     }
 }
 
 void ServerActivity::Stop ()
 {
+    if (isRecordingMatch_)
+    {
+        SaveMatchRecording ();
+    }
+
     Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
     network->StopServer ();
 }
@@ -133,6 +186,7 @@ void ServerActivity::ProcessRequestToChangeType (Urho3D::Connection *sender, Pla
                 countOfPlayers_ += (newType == PT_OBSERVER ? -1 : 1);
 
                 SendPlayerTypeToAllPlayers (connectionData);
+                AutoStartIfReady ();
                 return;
             }
         }
@@ -159,9 +213,11 @@ void ServerActivity::SetIsPlayerReady (Urho3D::Connection *sender, bool isReady)
 
             for (auto &anotherConnectionData : identifiedConnections_)
             {
-                anotherConnectionData.second_.connection_->SendMessage (
+                SendNetworkMessage (anotherConnectionData.second_.connection_,
                         STCNMT_PLAYER_READY_CHANGED, true, true, messageData);
             }
+
+            AutoStartIfReady ();
             return;
         }
     }
@@ -175,12 +231,206 @@ const Urho3D::String &ServerActivity::GetMapName () const
 void ServerActivity::SetMapName (const Urho3D::String &mapName)
 {
     mapName_ = mapName;
+    // Files of previous map are not needed anymore, clients will request new files after receiving new manifest.
+    mapFilesTransfers_.Clear ();
     CollectMapData ();
 
     for (auto &connectionData : identifiedConnections_)
     {
-        connectionData.second_.connection_->SendMessage (STCNMT_MAP_FILES, true, false, mapData_);
+        SendNetworkMessage (connectionData.second_.connection_, STCNMT_MAP_MANIFEST, true, true, mapManifest_);
+    }
+}
+
+unsigned int ServerActivity::GetServerPort () const
+{
+    return serverPort_;
+}
+
+void ServerActivity::SetServerPort (unsigned int serverPort)
+{
+    serverPort_ = serverPort;
+}
+
+bool ServerActivity::IsAutoStartWhenReady () const
+{
+    return autoStartWhenReady_;
+}
+
+void ServerActivity::SetAutoStartWhenReady (bool autoStartWhenReady)
+{
+    autoStartWhenReady_ = autoStartWhenReady;
+}
+
+const Urho3D::String &ServerActivity::GetStatisticsExportPath () const
+{
+    return statisticsExportPath_;
+}
+
+void ServerActivity::SetStatisticsExportPath (const Urho3D::String &statisticsExportPath)
+{
+    statisticsExportPath_ = statisticsExportPath;
+}
+
+float ServerActivity::GetStatisticsExportInterval () const
+{
+    return statisticsExportInterval_;
+}
+
+void ServerActivity::SetStatisticsExportInterval (float statisticsExportInterval)
+{
+    if (statisticsExportInterval <= 0.0f)
+    {
+        throw UniversalException <ServerActivity> ("ServerActivity: statistics export interval must be more than 0!");
+    }
+
+    statisticsExportInterval_ = statisticsExportInterval;
+    untilStatisticsExport_ = Urho3D::Min (untilStatisticsExport_, statisticsExportInterval_);
+}
+
+unsigned int ServerActivity::GetSimulationRate () const
+{
+    return simulationRate_;
+}
+
+void ServerActivity::SetSimulationRate (unsigned int simulationRate)
+{
+    if (simulationRate == 0)
+    {
+        throw UniversalException <ServerActivity> ("ServerActivity: simulation rate must be more than 0!");
+    }
+    simulationRate_ = simulationRate;
+}
+
+float ServerActivity::GetSimulationTimeStep () const
+{
+    return 1.0f / simulationRate_;
+}
+
+unsigned int ServerActivity::GetMaxCatchUpTicks () const
+{
+    return maxCatchUpTicks_;
+}
+
+void ServerActivity::SetMaxCatchUpTicks (unsigned int maxCatchUpTicks)
+{
+    if (maxCatchUpTicks == 0)
+    {
+        throw UniversalException <ServerActivity> ("ServerActivity: max catch up ticks must be more than 0!");
+    }
+    maxCatchUpTicks_ = maxCatchUpTicks;
+}
+
+unsigned int ServerActivity::GetSimulationTick () const
+{
+    return simulationTick_;
+}
+
+float ServerActivity::GetSimulationInterpolationFactor () const
+{
+    return Urho3D::Clamp (simulationAccumulator_ / GetSimulationTimeStep (), 0.0f, 1.0f);
+}
+
+bool ServerActivity::IsInterestManagementEnabled () const
+{
+    return interestManagementEnabled_;
+}
+
+void ServerActivity::SetInterestManagementEnabled (bool interestManagementEnabled)
+{
+    interestManagementEnabled_ = interestManagementEnabled;
+}
+
+const Urho3D::String &ServerActivity::GetMatchRecordingPath () const
+{
+    return matchRecordingPath_;
+}
+
+void ServerActivity::SetMatchRecordingPath (const Urho3D::String &matchRecordingPath)
+{
+    matchRecordingPath_ = matchRecordingPath;
+}
+
+const Urho3D::String &ServerActivity::GetReplayPath () const
+{
+    return replayPath_;
+}
+
+void ServerActivity::SetReplayPath (const Urho3D::String &replayPath)
+{
+    replayPath_ = replayPath;
+}
+
+void ServerActivity::ApplyPlayerInput (const MatchInput &input)
+{
+    if (managersHub_ == nullptr || currentGameStatus_ != GS_PLAYING)
+    {
+        return;
     }
+
+    if (isRecordingMatch_)
+    {
+        matchRecording_.AddInput (input);
+    }
+    ApplyMatchInput (managersHub_, input);
+}
+
+void ServerActivity::SendNetworkMessage (Urho3D::Connection *connection, int messageType, bool reliable, bool inOrder,
+        const Urho3D::VectorBuffer &messageData)
+{
+    // Players have no connections while match is replayed.
+    if (connection == nullptr)
+    {
+        return;
+    }
+
+    trafficStatistics_.RecordSent (connection, messageType, messageData.GetSize ());
+    connection->SendMessage (messageType, reliable, inOrder, messageData);
+}
+
+const NetworkTrafficStatistics &ServerActivity::GetTrafficStatistics () const
+{
+    return trafficStatistics_;
+}
+
+void ServerActivity::SendMapFiles (Urho3D::Connection *connection, const Urho3D::String &mapName,
+        const Urho3D::Vector <Urho3D::String> &fileNames)
+{
+    if (mapName != mapName_)
+    {
+        URHO3D_LOGDEBUG ("ServerActivity: ignored request of files of previous map " + mapName + ".");
+        return;
+    }
+
+    MapFilesTransfer transfer {connection, {}, 0, 0, 0, 0};
+    for (const Urho3D::String &fileName : fileNames)
+    {
+        auto iterator = mapFiles_.Find (fileName);
+        if (iterator == mapFiles_.End ())
+        {
+            URHO3D_LOGWARNING ("ServerActivity: client requested unknown map file " + fileName + "!");
+        }
+        else
+        {
+            transfer.fileNames_.Push (fileName);
+            transfer.transferSize_ += iterator->second_.Size ();
+        }
+    }
+
+    if (transfer.fileNames_.Empty ())
+    {
+        return;
+    }
+
+    // New request replaces unfinished one, client requests files again only after map change.
+    for (MapFilesTransfer &existingTransfer : mapFilesTransfers_)
+    {
+        if (existingTransfer.connection_ == connection)
+        {
+            existingTransfer = transfer;
+            return;
+        }
+    }
+    mapFilesTransfers_.Push (transfer);
 }
 
 const ServerActivity::IdentifiedConnectionsMap &ServerActivity::GetIdentifiedConnections () const
@@ -235,27 +485,28 @@ void ServerActivity::HandleClientIdentity (Urho3D::StringHash eventHash, Urho3D:
     newPlayerMessageData.WriteString (name);
     newPlayerMessageData.WriteUByte (PT_OBSERVER);
     newPlayerMessageData.WriteBool (false);
-    connection->SendMessage (STCNMT_NEW_PLAYER, true, true, newPlayerMessageData);
+    SendNetworkMessage (connection, STCNMT_NEW_PLAYER, true, true, newPlayerMessageData);
 
     for (auto &anotherConnectionData : identifiedConnections_)
     {
-        anotherConnectionData.second_.connection_->SendMessage (STCNMT_NEW_PLAYER, true, true, newPlayerMessageData);
+        SendNetworkMessage (anotherConnectionData.second_.connection_,
+                STCNMT_NEW_PLAYER, true, true, newPlayerMessageData);
 
         Urho3D::VectorBuffer messageData;
         messageData.WriteString (anotherConnectionData.first_);
         messageData.WriteUByte (anotherConnectionData.second_.playerType);
         messageData.WriteBool (anotherConnectionData.second_.readyForStart_);
 
-        connection->SendMessage (STCNMT_NEW_PLAYER, true, true, messageData);
+        SendNetworkMessage (connection, STCNMT_NEW_PLAYER, true, true, messageData);
     }
 
     identifiedConnections_ [name] = {connection, PT_OBSERVER, false};
     Urho3D::VectorBuffer data;
     data.WriteInt (currentGameStatus_);
 
-    connection->SendMessage (STCNMT_GAME_STATUS, true, false, data);
+    SendNetworkMessage (connection, STCNMT_GAME_STATUS, true, false, data);
     connection->SetScene (scene_);
-    connection->SendMessage (STCNMT_MAP_FILES, true, false, mapData_);
+    SendNetworkMessage (connection, STCNMT_MAP_MANIFEST, true, true, mapManifest_);
 }
 
 void ServerActivity::HandleClientDisconnected (Urho3D::StringHash eventHash, Urho3D::VariantMap &eventData)
@@ -263,6 +514,16 @@ void ServerActivity::HandleClientDisconnected (Urho3D::StringHash eventHash, Urh
     Urho3D::Connection *connection =
             dynamic_cast <Urho3D::Connection *> (eventData[Urho3D::ClientConnected::P_CONNECTION].GetPtr ());
 
+    trafficStatistics_.RemoveConnection (connection);
+    for (unsigned int index = 0; index < mapFilesTransfers_.Size (); index++)
+    {
+        if (mapFilesTransfers_ [index].connection_ == connection)
+        {
+            mapFilesTransfers_.Erase (index);
+            break;
+        }
+    }
+
     if (!RemoveUnidentifiedConnection (connection))
     {
         Urho3D::VectorBuffer messageData;
@@ -270,7 +531,8 @@ void ServerActivity::HandleClientDisconnected (Urho3D::StringHash eventHash, Urh
 
         for (auto &identifiedConnectionData : identifiedConnections_)
         {
-            identifiedConnectionData.second_.connection_->SendMessage (STCNMT_PLAYER_LEFT, true, false, messageData);
+            SendNetworkMessage (identifiedConnectionData.second_.connection_,
+                    STCNMT_PLAYER_LEFT, true, false, messageData);
         }
 
         if (currentGameStatus_ == GS_PLAYING)
@@ -296,8 +558,11 @@ void ServerActivity::HandleNetworkMessage (Urho3D::StringHash eventHash, Urho3D:
     if (messageId >= CTSNMT_START && messageId < CTSNMT_TYPES_COUNT)
     {
         Urho3D::VectorBuffer messageData = eventData [Urho3D::NetworkMessage::P_DATA].GetVectorBuffer ();
-        incomingNetworkMessageProcessors_[messageId - CTSNMT_START] (this, messageData,
-                dynamic_cast <Urho3D::Connection *> (eventData[Urho3D::NetworkMessage::P_CONNECTION].GetPtr ()));
+        Urho3D::Connection *sender =
+                dynamic_cast <Urho3D::Connection *> (eventData[Urho3D::NetworkMessage::P_CONNECTION].GetPtr ());
+
+        trafficStatistics_.RecordReceived (sender, messageId, messageData.GetSize ());
+        incomingNetworkMessageProcessors_[messageId - CTSNMT_START] (this, messageData, sender);
     }
 }
 
@@ -311,14 +576,7 @@ void ServerActivity::HandleComponentAdded (Urho3D::StringHash eventHash, Urho3D:
 
         if (dynamic_cast <Unit *> (component) != nullptr || dynamic_cast <Village *> (component) != nullptr)
         {
-            Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
-            Urho3D::VectorBuffer messageData;
-            messageData.WriteUInt (node->GetID ());
-
-            for (auto &connectionData : identifiedConnections_)
-            {
-                connectionData.second_.connection_->SendMessage (STCNMT_OBJECT_SPAWNED, true, false, messageData);
-            }
+            spawnedObjectsIDs_.Push (node->GetID ());
         }
     }
 }
@@ -330,8 +588,9 @@ void ServerActivity::HandlePlayerUnitsPullSync (Urho3D::StringHash eventHash, Ur
     messageData.WriteUInt (eventData [PlayerUnitsPullSync::UNIT_TYPE].GetUInt ());
     messageData.WriteUInt (eventData [PlayerUnitsPullSync::NEW_VALUE].GetUInt ());
 
-    (player == &dynamic_cast <PlayersManager *> (managersHub_->GetManager (MI_PLAYERS_MANAGER))->GetFirstPlayer () ?
-        firstPlayer_ : secondPlayer_)->SendMessage (STCNMT_UNITS_PULL_SYNC, true, false, messageData);
+    SendNetworkMessage (
+            player == &dynamic_cast <PlayersManager *> (managersHub_->GetManager (MI_PLAYERS_MANAGER))->GetFirstPlayer () ?
+            firstPlayer_ : secondPlayer_, STCNMT_UNITS_PULL_SYNC, true, false, messageData);
 }
 
 void ServerActivity::HandlePlayerCoinsSync (Urho3D::StringHash eventHash, Urho3D::VariantMap &eventData)
@@ -340,8 +599,9 @@ void ServerActivity::HandlePlayerCoinsSync (Urho3D::StringHash eventHash, Urho3D
     Urho3D::VectorBuffer messageData;
     messageData.WriteUInt (eventData [PlayerCoinsSync::NEW_VALUE].GetUInt ());
 
-    (player == &dynamic_cast <PlayersManager *> (managersHub_->GetManager (MI_PLAYERS_MANAGER))->GetFirstPlayer () ?
-            firstPlayer_ : secondPlayer_)->SendMessage (STCNMT_COINS_SYNC, true, false, messageData);
+    SendNetworkMessage (
+            player == &dynamic_cast <PlayersManager *> (managersHub_->GetManager (MI_PLAYERS_MANAGER))->GetFirstPlayer () ?
+            firstPlayer_ : secondPlayer_, STCNMT_COINS_SYNC, true, false, messageData);
 }
 
 void ServerActivity::HandleGameEnded (Urho3D::StringHash eventHash, Urho3D::VariantMap &eventData)
@@ -396,9 +656,21 @@ void ServerActivity::HandleRequestGameStart (Urho3D::StringHash eventHash, Urho3
     secondPlayer_ = secondData->second_.connection_;
 
     currentGameStatus_ = GS_PLAYING;
+    simulationAccumulator_ = 0.0f;
+    simulationTick_ = 0;
+    firstPlayerInterestFilter_.Clear ();
+    secondPlayerInterestFilter_.Clear ();
     unsigned int startCoins;
     LoadResources (startCoins);
     SetupPlayers (startCoins);
+
+    unsigned randomSeed = Urho3D::Time::GetSystemTime ();
+    dynamic_cast <UnitsManager *> (managersHub_->GetManager (MI_UNITS_MANAGER))->SetRandomSeed (randomSeed);
+    if (!matchRecordingPath_.Empty ())
+    {
+        matchRecording_.Setup (mapName_, randomSeed);
+        isRecordingMatch_ = true;
+    }
     ReportGameStatus ();
 
     SendPlayerTypeToAllPlayers (*firstData);
@@ -461,17 +733,278 @@ Urho3D::String ServerActivity::RemoveIdentifiedConnection (Urho3D::Connection *c
     return Urho3D::String::EMPTY;
 }
 
-void ServerActivity::ReportGameStatus () const
+void ServerActivity::ReportGameStatus ()
 {
     Urho3D::VectorBuffer data;
     data.WriteInt (currentGameStatus_);
 
     for (auto &connectionData : identifiedConnections_)
     {
-        connectionData.second_.connection_->SendMessage (STCNMT_GAME_STATUS, true, false, data);
+        SendNetworkMessage (connectionData.second_.connection_, STCNMT_GAME_STATUS, true, false, data);
+    }
+}
+
+void ServerActivity::AutoStartIfReady ()
+{
+    if (autoStartWhenReady_)
+    {
+        // Game start request checks players count and readiness itself.
+        SendEvent (E_REQUEST_GAME_START);
+    }
+}
+
+void ServerActivity::UpdateSimulation (float timeStep)
+{
+    float simulationTimeStep = GetSimulationTimeStep ();
+    simulationAccumulator_ += timeStep;
+    unsigned int ticks = 0;
+
+    while (simulationAccumulator_ >= simulationTimeStep && currentGameStatus_ == GS_PLAYING)
+    {
+        if (ticks == maxCatchUpTicks_)
+        {
+            URHO3D_LOGDEBUG ("ServerActivity: simulation is too slow, dropped " +
+                    Urho3D::String (simulationAccumulator_) + " s of frame time.");
+            simulationAccumulator_ = 0.0f;
+            break;
+        }
+
+        SimulateTick ();
+        simulationAccumulator_ -= simulationTimeStep;
+        ticks++;
+    }
+}
+
+void ServerActivity::UpdateUnitsInterest ()
+{
+    if (!interestManagementEnabled_ || currentGameStatus_ != GS_PLAYING)
+    {
+        // Units, that were hidden when filtering was stopped, must be replicated too.
+        if (firstPlayer_ != nullptr)
+        {
+            firstPlayerInterestFilter_.RevealAll (scene_, firstPlayer_);
+        }
+
+        if (secondPlayer_ != nullptr)
+        {
+            secondPlayerInterestFilter_.RevealAll (scene_, secondPlayer_);
+        }
+        return;
+    }
+
+    // Visibility is updated by simulation, so filters are applied after it. Network update later in this frame
+    // sends only changes of visible units.
+    const UnitsManager *unitsManager = dynamic_cast <const UnitsManager *> (managersHub_->GetManager (MI_UNITS_MANAGER));
+    if (firstPlayer_ != nullptr)
+    {
+        firstPlayerInterestFilter_.Apply (scene_, unitsManager, firstPlayer_, true);
+    }
+
+    if (secondPlayer_ != nullptr)
+    {
+        secondPlayerInterestFilter_.Apply (scene_, unitsManager, secondPlayer_, false);
+    }
+}
+
+void ServerActivity::SendSpawnedObjects ()
+{
+    Urho3D::PODVector <unsigned int> playerSpawnedObjectsIDs;
+    for (auto &connectionData : identifiedConnections_)
+    {
+        Urho3D::Connection *connection = connectionData.second_.connection_;
+        const Urho3D::PODVector <unsigned int> *spawnedObjectsIDs = &spawnedObjectsIDs_;
+
+        // Players receive ids of enemy units only after they see them, observers receive all ids.
+        if (connection == firstPlayer_ || connection == secondPlayer_)
+        {
+            UnitsInterestFilter &interestFilter =
+                    connection == firstPlayer_ ? firstPlayerInterestFilter_ : secondPlayerInterestFilter_;
+            playerSpawnedObjectsIDs.Clear ();
+            interestFilter.FilterSpawnedObjects (scene_, spawnedObjectsIDs_, playerSpawnedObjectsIDs);
+            spawnedObjectsIDs = &playerSpawnedObjectsIDs;
+        }
+
+        if (!spawnedObjectsIDs->Empty ())
+        {
+            Urho3D::VectorBuffer messageData;
+            messageData.WriteUInt (spawnedObjectsIDs->Size ());
+            for (unsigned int nodeID : *spawnedObjectsIDs)
+            {
+                messageData.WriteUInt (nodeID);
+            }
+            SendNetworkMessage (connection, STCNMT_OBJECT_SPAWNED, true, false, messageData);
+        }
+    }
+    spawnedObjectsIDs_.Clear ();
+}
+
+void ServerActivity::UpdateMapFilesTransfers ()
+{
+    unsigned int index = 0;
+    while (index < mapFilesTransfers_.Size ())
+    {
+        bool finished = false;
+        for (unsigned int chunk = 0; chunk < DEFAULT_MAP_FILES_CHUNKS_PER_UPDATE && !finished; chunk++)
+        {
+            finished = SendNextMapFilesChunk (mapFilesTransfers_ [index]);
+        }
+
+        if (finished)
+        {
+            mapFilesTransfers_.Erase (index);
+        }
+        else
+        {
+            index++;
+        }
+    }
+}
+
+bool ServerActivity::SendNextMapFilesChunk (MapFilesTransfer &transfer)
+{
+    const Urho3D::String &fileName = transfer.fileNames_ [transfer.fileIndex_];
+    const Urho3D::PODVector <unsigned char> &file = mapFiles_ [fileName];
+    unsigned int chunkSize = Urho3D::Min (DEFAULT_MAP_FILES_CHUNK_SIZE, file.Size () - transfer.fileOffset_);
+
+    compressionBuffer_.Resize (Urho3D::EstimateCompressBound (chunkSize));
+    unsigned int compressedSize = chunkSize > 0 ?
+            Urho3D::CompressData (compressionBuffer_.Buffer (), &file [transfer.fileOffset_], chunkSize) : 0;
+
+    Urho3D::VectorBuffer messageData;
+    messageData.WriteString (mapName_);
+    messageData.WriteUInt (transfer.transferSize_);
+    messageData.WriteUInt (transfer.transferOffset_);
+    messageData.WriteString (fileName);
+    messageData.WriteUInt (file.Size ());
+    messageData.WriteUInt (transfer.fileOffset_);
+    messageData.WriteUInt (chunkSize);
+    messageData.WriteUInt (compressedSize);
+    messageData.Write (compressionBuffer_.Buffer (), compressedSize);
+    SendNetworkMessage (transfer.connection_, STCNMT_MAP_FILES, true, true, messageData);
+
+    transfer.fileOffset_ += chunkSize;
+    transfer.transferOffset_ += chunkSize;
+    if (transfer.fileOffset_ >= file.Size ())
+    {
+        transfer.fileIndex_++;
+        transfer.fileOffset_ = 0;
+    }
+    return transfer.fileIndex_ >= transfer.fileNames_.Size ();
+}
+
+void ServerActivity::SimulateTick ()
+{
+    float simulationTimeStep = GetSimulationTimeStep ();
+    if (isRecordingMatch_)
+    {
+        matchRecording_.AddTick (simulationTimeStep);
+    }
+
+    managersHub_->HandleUpdate (simulationTimeStep);
+    simulationTick_++;
+}
+
+void ServerActivity::UpdateStatisticsExport (float timeStep)
+{
+    if (statisticsExportPath_.Empty ())
+    {
+        return;
+    }
+
+    untilStatisticsExport_ -= timeStep;
+    if (untilStatisticsExport_ <= 0.0f)
+    {
+        untilStatisticsExport_ = statisticsExportInterval_;
+        ExportStatistics ();
     }
 }
 
+void ServerActivity::ExportStatistics () const
+{
+    Urho3D::JSONFile statistics (context_);
+    managersHub_->SaveStatisticsToJSON (statistics.GetRoot ());
+
+    Urho3D::File file (context_, statisticsExportPath_, Urho3D::FILE_WRITE);
+    if (!file.IsOpen () || !statistics.Save (file, "    "))
+    {
+        URHO3D_LOGWARNING ("ServerActivity: can not export tick statistics to " + statisticsExportPath_ + "!");
+    }
+}
+
+void ServerActivity::SaveMatchRecording ()
+{
+    isRecordingMatch_ = false;
+    Urho3D::File file (context_, matchRecordingPath_, Urho3D::FILE_WRITE);
+
+    if (!file.IsOpen () || !matchRecording_.Save (file))
+    {
+        URHO3D_LOGERROR ("ServerActivity: can not save match recording to " + matchRecordingPath_ + "!");
+    }
+    else
+    {
+        URHO3D_LOGINFO ("ServerActivity: match recording with " + Urho3D::String (matchRecording_.GetTicksCount ()) +
+                " ticks is saved to " + matchRecordingPath_ + ".");
+    }
+    matchRecording_.Clear ();
+}
+
+void ServerActivity::RunReplay ()
+{
+    Urho3D::File file (context_, replayPath_, Urho3D::FILE_READ);
+    if (!file.IsOpen ())
+    {
+        throw UniversalException <ServerActivity> ("ServerActivity: can not open replay " + replayPath_ + "!");
+    }
+
+    MatchRecording recording;
+    recording.Load (file);
+    SetMapName (recording.GetMapName ());
+
+    managersHub_ = new ManagersHub (scene_);
+    currentGameStatus_ = GS_PLAYING;
+    unsigned int startCoins;
+    LoadResources (startCoins);
+    SetupPlayers (startCoins);
+    dynamic_cast <UnitsManager *> (managersHub_->GetManager (MI_UNITS_MANAGER))->SetRandomSeed (
+            recording.GetRandomSeed ());
+
+    const Urho3D::PODVector <float> &timeSteps = recording.GetTicksTimeSteps ();
+    const Urho3D::PODVector <MatchInput> &inputs = recording.GetInputs ();
+    unsigned nextInputIndex = 0;
+    float simulatedTime = 0.0f;
+    Urho3D::HiresTimer timer;
+
+    for (unsigned tick = 0; tick <= timeSteps.Size (); tick++)
+    {
+        while (nextInputIndex < inputs.Size () && inputs [nextInputIndex].tick_ == tick)
+        {
+            ApplyMatchInput (managersHub_, inputs [nextInputIndex]);
+            nextInputIndex++;
+        }
+
+        if (tick < timeSteps.Size ())
+        {
+            managersHub_->HandleUpdate (timeSteps [tick]);
+            simulatedTime += timeSteps [tick];
+            simulationTick_++;
+        }
+    }
+
+    long long elapsedTime = timer.GetUSec (false);
+    const UnitsManager *unitsManager = dynamic_cast <const UnitsManager *> (managersHub_->GetManager (MI_UNITS_MANAGER));
+    URHO3D_LOGINFO ("ServerActivity: replayed " + Urho3D::String (timeSteps.Size ()) + " ticks (" +
+            Urho3D::String (simulatedTime) + " s of match on map " + recording.GetMapName () + ") in " +
+            Urho3D::String (elapsedTime / 1000) + " ms, " + Urho3D::String (unitsManager->GetUnitsState ().Size ()) +
+            " units left, game status " + Urho3D::String (static_cast <int> (currentGameStatus_)) + ".");
+
+    // Recording may end before game end, replayed match must not be continued by Update with real time steps.
+    if (currentGameStatus_ == GS_PLAYING)
+    {
+        currentGameStatus_ = GS_WAITING;
+    }
+    SendEvent (E_SHUTDOWN_ALL_ACTIVITIES);
+}
+
 void ServerActivity::ProcessUnidentifiedConnections (float timeStep)
 {
     for (auto iterator = unidentifiedConnections_.Begin (); iterator != unidentifiedConnections_.End ();)
@@ -614,32 +1147,40 @@ void ServerActivity::SendPlayerTypeToAllPlayers (IdentifiedConnectionsMap::KeyVa
 
     for (auto &connection : identifiedConnections_)
     {
-        connection.second_.connection_->SendMessage (STCNMT_PLAYER_TYPE_CHANGED, true, true, messageData);
+        SendNetworkMessage (connection.second_.connection_, STCNMT_PLAYER_TYPE_CHANGED, true, true, messageData);
     }
 }
 
 void ServerActivity::CollectMapData ()
 {
-    mapData_.Clear ();
+    mapManifest_.Clear ();
+    mapFiles_.Clear ();
     Urho3D::Vector <Urho3D::String> mapFiles;
     context_->GetSubsystem <Urho3D::FileSystem> ()->ScanDir (
             mapFiles, "Data/" + DEFAULT_MAPS_FOLDER + "/" + mapName_, "*", Urho3D::SCAN_FILES, true);
 
-    mapData_.WriteString (mapName_);
-    mapData_.WriteUInt (mapFiles.Size ());
+    mapManifest_.WriteString (mapName_);
+    mapManifest_.WriteUInt (mapFiles.Size ());
 
     for (auto &fileName : mapFiles)
     {
         Urho3D::File *file = new Urho3D::File (context_,
                 "Data/" + DEFAULT_MAPS_FOLDER + "/" + mapName_ + "/" + fileName, Urho3D::FILE_READ);
 
-        Urho3D::PODVector <unsigned char> buffer (file->GetSize ());
+        Urho3D::PODVector <unsigned char> &buffer = mapFiles_ [fileName];
+        buffer.Resize (file->GetSize ());
         file->Read (&buffer [0], file->GetSize ());
         file->Close ();
 
-        mapData_.WriteString (fileName);
-        mapData_.WriteBuffer (buffer);
+        unsigned int checksum = 0;
+        for (unsigned char byte : buffer)
+        {
+            checksum = Urho3D::SDBMHash (checksum, byte);
+        }
+
+        mapManifest_.WriteString (fileName);
+        mapManifest_.WriteUInt (buffer.Size ());
+        mapManifest_.WriteUInt (checksum);
     }
 }
 }
-
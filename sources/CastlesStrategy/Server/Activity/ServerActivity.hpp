@@ -3,8 +3,11 @@
 #include <Urho3D/Network/Connection.h>
 #include <Urho3D/Scene/Scene.h>
 
+#include <CastlesStrategy/Server/Activity/UnitsInterestFilter.hpp>
 #include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
+#include <CastlesStrategy/Server/Replay/MatchRecording.hpp>
 #include <CastlesStrategy/Shared/Network/GameStatus.hpp>
+#include <CastlesStrategy/Shared/Network/NetworkTrafficStatistics.hpp>
 #include <CastlesStrategy/Shared/PlayerType.hpp>
 #include <ActivitiesApplication/Activity.hpp>
 
@@ -25,6 +28,17 @@ public:
         bool readyForStart_;
     };
 
+    /// Requested map files are sent by chunks during several updates, so reliable channel is not blocked.
+    struct MapFilesTransfer
+    {
+        Urho3D::Connection *connection_;
+        Urho3D::Vector <Urho3D::String> fileNames_;
+        unsigned int fileIndex_;
+        unsigned int fileOffset_;
+        unsigned int transferSize_;
+        unsigned int transferOffset_;
+    };
+
     typedef Urho3D::PODVector <Urho3D::Pair <Urho3D::Connection *, float> > UnidentifiedConnectionsVector;
     typedef Urho3D::HashMap <Urho3D::String, ServerActivity::PlayerData> IdentifiedConnectionsMap;
 
@@ -41,6 +55,61 @@ public:
     const Urho3D::String &GetMapName () const;
     void SetMapName (const Urho3D::String &mapName);
 
+    unsigned int GetServerPort () const;
+    /// Must be called before activity start.
+    void SetServerPort (unsigned int serverPort);
+
+    /// If true, game starts without admin request when two players and all observers are ready.
+    bool IsAutoStartWhenReady () const;
+    void SetAutoStartWhenReady (bool autoStartWhenReady);
+
+    /// Managers hub tick statistics are written to this file while game is playing. Empty path disables export.
+    const Urho3D::String &GetStatisticsExportPath () const;
+    void SetStatisticsExportPath (const Urho3D::String &statisticsExportPath);
+
+    float GetStatisticsExportInterval () const;
+    void SetStatisticsExportInterval (float statisticsExportInterval);
+
+    /// Simulation runs with fixed time step, equal to 1 / simulation rate, independently from frame rate.
+    unsigned int GetSimulationRate () const;
+    void SetSimulationRate (unsigned int simulationRate);
+    float GetSimulationTimeStep () const;
+
+    /// If frame is too long, only this count of ticks is simulated and the rest of frame time is dropped.
+    unsigned int GetMaxCatchUpTicks () const;
+    void SetMaxCatchUpTicks (unsigned int maxCatchUpTicks);
+
+    /// Count of ticks simulated since match start.
+    unsigned int GetSimulationTick () const;
+    /// Part of next tick time step, which is already accumulated. Can be used to interpolate between last two ticks.
+    float GetSimulationInterpolationFactor () const;
+
+    /// If true, players receive only enemy units, which are seen by their units. Observers always receive all units.
+    bool IsInterestManagementEnabled () const;
+    void SetInterestManagementEnabled (bool interestManagementEnabled);
+
+    /// If not empty, players inputs of next match are recorded and saved to this file after match end.
+    const Urho3D::String &GetMatchRecordingPath () const;
+    void SetMatchRecordingPath (const Urho3D::String &matchRecordingPath);
+
+    /// If not empty, activity does not start server and instead replays match from this file as fast as possible,
+    /// then logs replay results and requests activities shutdown. Must be set before activity start.
+    const Urho3D::String &GetReplayPath () const;
+    void SetReplayPath (const Urho3D::String &replayPath);
+
+    /// Applies input of player to current match and records it if match recording is enabled.
+    void ApplyPlayerInput (const MatchInput &input);
+
+    /// Sends message and records it in traffic statistics. All custom messages should be sent through this method.
+    void SendNetworkMessage (Urho3D::Connection *connection, int messageType, bool reliable, bool inOrder,
+            const Urho3D::VectorBuffer &messageData);
+    const NetworkTrafficStatistics &GetTrafficStatistics () const;
+
+    /// Starts transfer of requested files of current map. Requests for previous map are ignored, because client
+    /// receives manifest of new map after map change.
+    void SendMapFiles (Urho3D::Connection *connection, const Urho3D::String &mapName,
+            const Urho3D::Vector <Urho3D::String> &fileNames);
+
     const IdentifiedConnectionsMap &GetIdentifiedConnections () const;
     ManagersHub *GetManagersHub () const;
 
@@ -64,7 +133,21 @@ private:
 
     bool RemoveUnidentifiedConnection (Urho3D::Connection *connection);
     Urho3D::String RemoveIdentifiedConnection (Urho3D::Connection *connection);
-    void ReportGameStatus () const;
+    void ReportGameStatus ();
+    void AutoStartIfReady ();
+    void UpdateSimulation (float timeStep);
+    void SimulateTick ();
+    void UpdateStatisticsExport (float timeStep);
+    void UpdateUnitsInterest ();
+    /// Sends node IDs of units and villages, added since previous update, as one message to each connection.
+    /// Players receive IDs of hidden enemy units later, when they see these units.
+    void SendSpawnedObjects ();
+    void UpdateMapFilesTransfers ();
+    /// Returns true if transfer is finished.
+    bool SendNextMapFilesChunk (MapFilesTransfer &transfer);
+    void SaveMatchRecording ();
+    void RunReplay ();
+    void ExportStatistics () const;
     void ProcessUnidentifiedConnections (float timeStep);
 
     void LoadResources (unsigned int &startCoins);
@@ -80,6 +163,23 @@ private:
 
     float autoDisconnectTime_;
     unsigned int serverPort_;
+    unsigned int simulationRate_;
+    unsigned int maxCatchUpTicks_;
+    float simulationAccumulator_;
+    unsigned int simulationTick_;
+    bool autoStartWhenReady_;
+    Urho3D::String statisticsExportPath_;
+    float statisticsExportInterval_;
+    float untilStatisticsExport_;
+    NetworkTrafficStatistics trafficStatistics_;
+    bool interestManagementEnabled_;
+    UnitsInterestFilter firstPlayerInterestFilter_;
+    UnitsInterestFilter secondPlayerInterestFilter_;
+
+    Urho3D::String matchRecordingPath_;
+    MatchRecording matchRecording_;
+    bool isRecordingMatch_;
+    Urho3D::String replayPath_;
 
     GameStatus currentGameStatus_;
     UnidentifiedConnectionsVector unidentifiedConnections_;
@@ -88,7 +188,12 @@ private:
     ManagersHub *managersHub_;
     Urho3D::Scene *scene_;
     Urho3D::String mapName_;
-    Urho3D::VectorBuffer mapData_;
+    /// Map files are sent by request, clients get only manifest with files sizes and checksums.
+    Urho3D::VectorBuffer mapManifest_;
+    Urho3D::HashMap <Urho3D::String, Urho3D::PODVector <unsigned char> > mapFiles_;
+    Urho3D::Vector <MapFilesTransfer> mapFilesTransfers_;
+    Urho3D::PODVector <unsigned char> compressionBuffer_;
+    Urho3D::PODVector <unsigned int> spawnedObjectsIDs_;
 
     Urho3D::PODVector <ServerIncomingNetworkMessageProcessor> incomingNetworkMessageProcessors_;
     unsigned int countOfPlayers_;
@@ -0,0 +1,164 @@
+#include "UnitsInterestFilter.hpp"
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+
+namespace CastlesStrategy
+{
+UnitsInterestFilter::UnitsInterestFilter () :
+        hiddenNodes_ (),
+        currentHiddenNodes_ (),
+        hiddenSpawnedNodes_ ()
+{
+
+}
+
+UnitsInterestFilter::~UnitsInterestFilter ()
+{
+
+}
+
+void UnitsInterestFilter::Apply (Urho3D::Scene *scene, const UnitsManager *unitsManager,
+        Urho3D::Connection *connection, bool forFirst)
+{
+    Urho3D::SceneReplicationState *sceneState = GetSceneReplicationState (scene, connection);
+    // Scene is not replicated to this connection yet, so there is nothing to filter.
+    if (sceneState != nullptr)
+    {
+        Apply (scene, sceneState, unitsManager, forFirst);
+    }
+}
+
+void UnitsInterestFilter::Apply (Urho3D::Scene *scene, Urho3D::SceneReplicationState *sceneState,
+        const UnitsManager *unitsManager, bool forFirst)
+{
+    const UnitsState &unitsState = unitsManager->GetUnitsState ();
+    currentHiddenNodes_.Clear ();
+
+    for (unsigned int index = 0; index < unitsState.Size (); index++)
+    {
+        if (!unitsManager->IsUnitVisibleForTeam (index, forFirst))
+        {
+            Hide (sceneState, unitsState.units_ [index]->GetNode ()->GetID ());
+        }
+    }
+
+    // Hidden nodes stay marked dirty, so engine does not add them to dirty nodes again. Revealed nodes are added
+    // manually: connection sends changes, accumulated while node was hidden, or creates node if it was hidden since
+    // its creation, and then clears dirty mark.
+    for (unsigned int nodeId : hiddenNodes_)
+    {
+        if (!currentHiddenNodes_.Contains (nodeId))
+        {
+            Urho3D::Node *node = scene->GetNode (nodeId);
+            Unit *unit = node != nullptr ? node->GetComponent <Unit> () : nullptr;
+
+            // Dead units are removed from units state, but their nodes are kept in units pool.
+            if (unit != nullptr && unitsManager->GetUnit (unit->GetID ()) == nullptr)
+            {
+                Hide (sceneState, nodeId);
+            }
+            else
+            {
+                // Connection sends remove message for removed node only if player has seen it.
+                sceneState->dirtyNodes_.Insert (nodeId);
+            }
+        }
+    }
+    hiddenNodes_.Swap (currentHiddenNodes_);
+}
+
+void UnitsInterestFilter::FilterSpawnedObjects (Urho3D::Scene *scene,
+        const Urho3D::PODVector <unsigned int> &spawnedObjectsIDs, Urho3D::PODVector <unsigned int> &output)
+{
+    auto iterator = hiddenSpawnedNodes_.Begin ();
+    while (iterator != hiddenSpawnedNodes_.End ())
+    {
+        if (scene->GetNode (*iterator) == nullptr)
+        {
+            iterator = hiddenSpawnedNodes_.Erase (iterator);
+        }
+        else if (!hiddenNodes_.Contains (*iterator))
+        {
+            output.Push (*iterator);
+            iterator = hiddenSpawnedNodes_.Erase (iterator);
+        }
+        else
+        {
+            iterator++;
+        }
+    }
+
+    for (unsigned int nodeId : spawnedObjectsIDs)
+    {
+        if (hiddenNodes_.Contains (nodeId))
+        {
+            hiddenSpawnedNodes_.Insert (nodeId);
+        }
+        else
+        {
+            output.Push (nodeId);
+        }
+    }
+}
+
+void UnitsInterestFilter::RevealAll (Urho3D::Scene *scene, Urho3D::Connection *connection)
+{
+    Urho3D::SceneReplicationState *sceneState = GetSceneReplicationState (scene, connection);
+    if (sceneState != nullptr)
+    {
+        for (unsigned int nodeId : hiddenNodes_)
+        {
+            sceneState->dirtyNodes_.Insert (nodeId);
+        }
+    }
+
+    // Ids of hidden spawned units are kept, so they are sent with next spawned objects.
+    hiddenNodes_.Clear ();
+    currentHiddenNodes_.Clear ();
+}
+
+void UnitsInterestFilter::Clear ()
+{
+    hiddenNodes_.Clear ();
+    currentHiddenNodes_.Clear ();
+    hiddenSpawnedNodes_.Clear ();
+}
+
+unsigned int UnitsInterestFilter::GetHiddenUnitsCount () const
+{
+    return hiddenNodes_.Size ();
+}
+
+void UnitsInterestFilter::Hide (Urho3D::SceneReplicationState *sceneState, unsigned int nodeId)
+{
+    currentHiddenNodes_.Insert (nodeId);
+    sceneState->dirtyNodes_.Erase (nodeId);
+
+    // Engine adds node to dirty nodes only if its replication state is not marked dirty yet. Changed
+    // attributes are still accumulated in replication state while it is marked.
+    auto iterator = sceneState->nodeStates_.Find (nodeId);
+    if (iterator != sceneState->nodeStates_.End ())
+    {
+        iterator->second_.markedDirty_ = true;
+    }
+}
+
+Urho3D::SceneReplicationState *UnitsInterestFilter::GetSceneReplicationState (Urho3D::Scene *scene,
+        Urho3D::Connection *connection)
+{
+    // Replication states of scene node are created by connections, each of them points to scene state of connection.
+    Urho3D::NetworkState *networkState = scene->GetNetworkState ();
+    if (networkState == nullptr)
+    {
+        return nullptr;
+    }
+
+    for (Urho3D::ReplicationState *state : networkState->replicationStates_)
+    {
+        if (state->connection_ == connection)
+        {
+            return static_cast <Urho3D::NodeReplicationState *> (state)->sceneState_;
+        }
+    }
+    return nullptr;
+}
+}
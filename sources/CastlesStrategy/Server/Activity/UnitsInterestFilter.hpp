@@ -0,0 +1,47 @@
+#pragma once
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Scene/ReplicationState.h>
+#include <Urho3D/Scene/Scene.h>
+#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
+
+namespace CastlesStrategy
+{
+/// Server side interest management for one player connection. Urho3D replicates every node to every connection,
+/// so filter removes nodes of enemy units, which player can not see, from dirty nodes of player connection and
+/// keeps their replication states marked as dirty, so Scene::PrepareNetworkUpdate does not queue their changes
+/// again. Hidden units are not created on player client until they are seen and seen units are frozen at last
+/// seen state after they are hidden again. Changes, accumulated while unit was hidden, are sent when it is revealed.
+/// Pooled nodes of dead units stay hidden until they are reused and seen or removed from scene.
+class UnitsInterestFilter
+{
+public:
+    UnitsInterestFilter ();
+    virtual ~UnitsInterestFilter ();
+
+    /// Must be called after simulation and before network update, otherwise hidden units, spawned during this
+    /// update, will be sent.
+    void Apply (Urho3D::Scene *scene, const UnitsManager *unitsManager, Urho3D::Connection *connection, bool forFirst);
+    void Apply (Urho3D::Scene *scene, Urho3D::SceneReplicationState *sceneState, const UnitsManager *unitsManager,
+            bool forFirst);
+    /// Appends spawned objects, which player can see, to output. Ids of hidden units are kept and appended after
+    /// units are revealed, so player does not receive ids of enemy units, that it can not see.
+    void FilterSpawnedObjects (Urho3D::Scene *scene, const Urho3D::PODVector <unsigned int> &spawnedObjectsIDs,
+            Urho3D::PODVector <unsigned int> &output);
+    /// Queues all hidden units for replication, used when filtering is stopped.
+    void RevealAll (Urho3D::Scene *scene, Urho3D::Connection *connection);
+    void Clear ();
+    unsigned int GetHiddenUnitsCount () const;
+
+private:
+    void Hide (Urho3D::SceneReplicationState *sceneState, unsigned int nodeId);
+    static Urho3D::SceneReplicationState *GetSceneReplicationState (Urho3D::Scene *scene,
+            Urho3D::Connection *connection);
+
+    /// Ids of units nodes, that were hidden during last apply.
+    Urho3D::HashSet <unsigned int> hiddenNodes_;
+    Urho3D::HashSet <unsigned int> currentHiddenNodes_;
+    /// Ids of spawned units nodes, that were hidden when they were spawned.
+    Urho3D::HashSet <unsigned int> hiddenSpawnedNodes_;
+};
+}
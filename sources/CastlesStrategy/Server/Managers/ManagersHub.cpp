@@ -1,4 +1,7 @@
 #include "ManagersHub.hpp"
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+
 #include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
 #include <CastlesStrategy/Server/Managers/Map.hpp>
 #include <CastlesStrategy/Server/Managers/PlayersManager.hpp>
@@ -7,9 +10,15 @@
 
 namespace CastlesStrategy
 {
+static const char *MANAGERS_NAMES [MI_MANAGERS_COUNT] = {"UnitsManager", "Map", "PlayersManager", "VillagesManager"};
+
 ManagersHub::ManagersHub (Urho3D::Scene *scene) :
         managers_ (MI_MANAGERS_COUNT),
-        scene_ (scene)
+        scene_ (scene),
+
+        managersStatistics_ (MI_MANAGERS_COUNT),
+        sceneUpdateStatistics_ (),
+        tickStatistics_ ()
 {
     managers_ [MI_UNITS_MANAGER] = new UnitsManager (this);
     managers_ [MI_MAP] = new Map (this);
@@ -52,14 +61,99 @@ Urho3D::Scene *ManagersHub::GetScene () const
 
 void ManagersHub::HandleUpdate (float timeStep)
 {
+#ifdef URHO3D_PROFILING
+    Urho3D::Profiler *profiler = scene_ != nullptr ? scene_->GetSubsystem <Urho3D::Profiler> () : nullptr;
+#endif
+    Urho3D::HiresTimer tickTimer;
+    Urho3D::HiresTimer stageTimer;
+
     if (scene_ != nullptr)
     {
+#ifdef URHO3D_PROFILING
+        Urho3D::AutoProfileBlock profileBlock (profiler, "ManagersHubSceneUpdate");
+#endif
         scene_->Update (timeStep);
     }
+    sceneUpdateStatistics_.AddSample (stageTimer.GetUSec (true));
 
-    for (Manager *&manager : managers_)
+    for (unsigned index = 0; index < MI_MANAGERS_COUNT; index++)
+    {
+#ifdef URHO3D_PROFILING
+        Urho3D::AutoProfileBlock profileBlock (profiler, MANAGERS_NAMES [index]);
+#endif
+        managers_ [index]->HandleUpdate (timeStep);
+        managersStatistics_ [index].AddSample (stageTimer.GetUSec (true));
+    }
+    tickStatistics_.AddSample (tickTimer.GetUSec (false));
+}
+
+const char *ManagersHub::GetManagerName (ManagerIndex index)
+{
+    if (index == MI_MANAGERS_COUNT)
+    {
+        throw UniversalException <ManagersHub> ("ManagersHub: manager index is out of range!");
+    }
+
+    return MANAGERS_NAMES [index];
+}
+
+const TickStatistics &ManagersHub::GetManagerStatistics (ManagerIndex index) const
+{
+    if (index == MI_MANAGERS_COUNT)
+    {
+        throw UniversalException <ManagersHub> ("ManagersHub: manager index is out of range!");
+    }
+
+    return managersStatistics_ [index];
+}
+
+const TickStatistics &ManagersHub::GetSceneUpdateStatistics () const
+{
+    return sceneUpdateStatistics_;
+}
+
+const TickStatistics &ManagersHub::GetTickStatistics () const
+{
+    return tickStatistics_;
+}
+
+void ManagersHub::ClearStatistics ()
+{
+    for (TickStatistics &statistics : managersStatistics_)
+    {
+        statistics.Clear ();
+    }
+
+    sceneUpdateStatistics_.Clear ();
+    tickStatistics_.Clear ();
+}
+
+void ManagersHub::SetStatisticsWindowSize (unsigned windowSize)
+{
+    for (TickStatistics &statistics : managersStatistics_)
+    {
+        statistics = TickStatistics (windowSize);
+    }
+
+    sceneUpdateStatistics_ = TickStatistics (windowSize);
+    tickStatistics_ = TickStatistics (windowSize);
+}
+
+void ManagersHub::SaveStatisticsToJSON (Urho3D::JSONValue &output) const
+{
+    Urho3D::JSONValue tick;
+    tickStatistics_.SaveToJSON (tick);
+    output ["Tick"] = tick;
+
+    Urho3D::JSONValue sceneUpdate;
+    sceneUpdateStatistics_.SaveToJSON (sceneUpdate);
+    output ["SceneUpdate"] = sceneUpdate;
+
+    for (unsigned index = 0; index < MI_MANAGERS_COUNT; index++)
     {
-        manager->HandleUpdate (timeStep);
+        Urho3D::JSONValue manager;
+        managersStatistics_ [index].SaveToJSON (manager);
+        output [MANAGERS_NAMES [index]] = manager;
     }
 }
 }
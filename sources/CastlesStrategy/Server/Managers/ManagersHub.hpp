@@ -2,6 +2,7 @@
 #include <Urho3D/Container/Vector.h>
 #include <Urho3D/Scene/Scene.h>
 #include <CastlesStrategy/Server/Managers/Manager.hpp>
+#include <CastlesStrategy/Server/Managers/TickStatistics.hpp>
 
 namespace CastlesStrategy
 {
@@ -26,8 +27,25 @@ public:
     Urho3D::Scene *GetScene () const;
     void HandleUpdate (float timeStep);
 
+    static const char *GetManagerName (ManagerIndex index);
+    /// Durations of manager HandleUpdate calls, in microseconds.
+    const TickStatistics &GetManagerStatistics (ManagerIndex index) const;
+    /// Durations of scene updates, which include crowd and navigation, in microseconds.
+    const TickStatistics &GetSceneUpdateStatistics () const;
+    /// Durations of whole HandleUpdate calls, in microseconds.
+    const TickStatistics &GetTickStatistics () const;
+
+    void ClearStatistics ();
+    /// Clears statistics and sets count of last ticks, which they keep.
+    void SetStatisticsWindowSize (unsigned windowSize);
+    void SaveStatisticsToJSON (Urho3D::JSONValue &output) const;
+
 private:
     Urho3D::PODVector <Manager *> managers_;
     Urho3D::Scene *scene_;
+
+    Urho3D::Vector <TickStatistics> managersStatistics_;
+    TickStatistics sceneUpdateStatistics_;
+    TickStatistics tickStatistics_;
 };
 }
@@ -1,10 +1,16 @@
 #include "Map.hpp"
+#include <climits>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
 #include <Utils/UniversalException.hpp>
 
 namespace CastlesStrategy
 {
 Map::Map (ManagersHub *managersHub) : Manager (managersHub),
-    routes_ ()
+    routes_ (),
+    projectedWaypoints_ ()
 {
 
 }
@@ -36,20 +42,33 @@ const std::vector <Route> &Map::GetRoutes () const
 
 Urho3D::Vector2 Map::GetWaypoint (unsigned int route, unsigned int index, bool isBelongsToFirst) const
 {
-    if (route >= routes_.size ())
-    {
-        throw UniversalException <Map> ("Map: requested route " + Urho3D::String (route) + ", but there is only " +
-            Urho3D::String (routes_.size ()) + " routes!");
-    }
+    return routes_ [route].GetWaypoints () [GetWaypointIndex (route, index, isBelongsToFirst)];
+}
 
-    const Route &requestedRoute = routes_ [route];
-    if (index >= requestedRoute.GetWaypoints ().Size ())
+const Urho3D::Vector3 &Map::GetProjectedWaypoint (unsigned int route, unsigned int index, bool isBelongsToFirst) const
+{
+    return projectedWaypoints_ [route] [GetWaypointIndex (route, index, isBelongsToFirst)];
+}
+
+void Map::ProjectRoutesOnNavigationMesh ()
+{
+    Urho3D::Scene *scene = GetManagersHub ()->GetScene ();
+    Urho3D::NavigationMesh *navigationMesh =
+            scene != nullptr ? scene->GetComponent <Urho3D::NavigationMesh> () : nullptr;
+
+    projectedWaypoints_.clear ();
+    for (const Route &route : routes_)
     {
-        throw UniversalException <Map> ("Map: requested route waypoint " + Urho3D::String (index) + ", but there is only " +
-                                                Urho3D::String (requestedRoute.GetWaypoints ().Size ()) + " waypoints!");
+        // Second player walks the same waypoints in reverse order, so one projection covers both directions.
+        Urho3D::PODVector <Urho3D::Vector3> projected;
+        for (const Urho3D::Vector2 &waypoint : route.GetWaypoints ())
+        {
+            Urho3D::Vector3 point (waypoint.x_, 0.0f, waypoint.y_);
+            projected.Push (navigationMesh != nullptr ?
+                    navigationMesh->FindNearestPoint (point, Urho3D::Vector3 (1.0f, INT_MAX, 1.0f)) : point);
+        }
+        projectedWaypoints_.push_back (projected);
     }
-
-    return requestedRoute.GetWaypoints () [isBelongsToFirst ? index : requestedRoute.GetWaypoints ().Size () - index - 1];
 }
 
 void Map::SaveRoutesToXML (Urho3D::XMLElement &output) const
@@ -71,5 +90,24 @@ void Map::LoadRoutesFromXML (const Urho3D::XMLElement &input)
         routes_.push_back (Route::LoadFromXML (element));
         element = element.GetNext ("route");
     }
+    ProjectRoutesOnNavigationMesh ();
+}
+
+unsigned int Map::GetWaypointIndex (unsigned int route, unsigned int index, bool isBelongsToFirst) const
+{
+    if (route >= routes_.size ())
+    {
+        throw UniversalException <Map> ("Map: requested route " + Urho3D::String (route) + ", but there is only " +
+            Urho3D::String (routes_.size ()) + " routes!");
+    }
+
+    const Route &requestedRoute = routes_ [route];
+    if (index >= requestedRoute.GetWaypoints ().Size ())
+    {
+        throw UniversalException <Map> ("Map: requested route waypoint " + Urho3D::String (index) + ", but there is only " +
+                                                Urho3D::String (requestedRoute.GetWaypoints ().Size ()) + " waypoints!");
+    }
+
+    return isBelongsToFirst ? index : requestedRoute.GetWaypoints ().Size () - index - 1;
 }
 }
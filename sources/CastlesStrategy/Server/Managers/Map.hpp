@@ -18,12 +18,19 @@ public:
 
     const std::vector <Route> &GetRoutes () const;
     Urho3D::Vector2 GetWaypoint (unsigned int route, unsigned int index, bool isBelongsToFirst) const;
+    /// Returns waypoint projected on scene navigation mesh. Waypoints are projected once after routes loading.
+    const Urho3D::Vector3 &GetProjectedWaypoint (unsigned int route, unsigned int index, bool isBelongsToFirst) const;
+    /// Must be called again if navigation mesh is built or changed after routes loading.
+    void ProjectRoutesOnNavigationMesh ();
 
     void SaveRoutesToXML (Urho3D::XMLElement &output) const;
     void LoadRoutesFromXML (const Urho3D::XMLElement &input);
 
 private:
+    unsigned int GetWaypointIndex (unsigned int route, unsigned int index, bool isBelongsToFirst) const;
+
     Urho3D::IntVector2 size_;
     std::vector <Route> routes_;
+    std::vector <Urho3D::PODVector <Urho3D::Vector3> > projectedWaypoints_;
 };
 }
@@ -0,0 +1,113 @@
+#include "TickStatistics.hpp"
+#include <Urho3D/Container/Sort.h>
+#include <Utils/UniversalException.hpp>
+
+namespace CastlesStrategy
+{
+TickStatistics::TickStatistics (unsigned windowSize) :
+        samples_ (),
+        windowSize_ (windowSize),
+        nextSampleIndex_ (0)
+{
+    if (windowSize_ == 0)
+    {
+        throw UniversalException <TickStatistics> ("TickStatistics: window size must be more than 0!");
+    }
+}
+
+TickStatistics::~TickStatistics ()
+{
+
+}
+
+void TickStatistics::AddSample (float duration)
+{
+    if (samples_.Size () < windowSize_)
+    {
+        samples_.Push (duration);
+    }
+    else
+    {
+        samples_ [nextSampleIndex_] = duration;
+    }
+    nextSampleIndex_ = (nextSampleIndex_ + 1) % windowSize_;
+}
+
+void TickStatistics::Clear ()
+{
+    samples_.Clear ();
+    nextSampleIndex_ = 0;
+}
+
+unsigned TickStatistics::GetSamplesCount () const
+{
+    return samples_.Size ();
+}
+
+unsigned TickStatistics::GetWindowSize () const
+{
+    return windowSize_;
+}
+
+float TickStatistics::GetMin () const
+{
+    if (samples_.Empty ())
+    {
+        return 0.0f;
+    }
+
+    float min = samples_ [0];
+    for (float sample : samples_)
+    {
+        min = Urho3D::Min (min, sample);
+    }
+    return min;
+}
+
+float TickStatistics::GetAverage () const
+{
+    if (samples_.Empty ())
+    {
+        return 0.0f;
+    }
+
+    float sum = 0.0f;
+    for (float sample : samples_)
+    {
+        sum += sample;
+    }
+    return sum / samples_.Size ();
+}
+
+float TickStatistics::GetMax () const
+{
+    float max = 0.0f;
+    for (float sample : samples_)
+    {
+        max = Urho3D::Max (max, sample);
+    }
+    return max;
+}
+
+float TickStatistics::GetPercentile (float percentile) const
+{
+    if (samples_.Empty ())
+    {
+        return 0.0f;
+    }
+
+    Urho3D::PODVector <float> sorted = samples_;
+    Urho3D::Sort (sorted.Begin (), sorted.End ());
+    unsigned index = Urho3D::CeilToInt (Urho3D::Clamp (percentile, 0.0f, 1.0f) * sorted.Size ());
+    return sorted [Urho3D::Clamp (index, 1u, sorted.Size ()) - 1];
+}
+
+void TickStatistics::SaveToJSON (Urho3D::JSONValue &output) const
+{
+    output ["samples"] = GetSamplesCount ();
+    output ["min"] = GetMin ();
+    output ["average"] = GetAverage ();
+    output ["max"] = GetMax ();
+    output ["p99"] = GetPercentile (0.99f);
+}
+}
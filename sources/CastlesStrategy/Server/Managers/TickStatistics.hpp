@@ -0,0 +1,34 @@
+#pragma once
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Resource/JSONValue.h>
+
+namespace CastlesStrategy
+{
+const unsigned DEFAULT_TICK_STATISTICS_WINDOW_SIZE = 600;
+
+/// Rolling statistics of last window size durations of some tick stage, in microseconds.
+class TickStatistics
+{
+public:
+    explicit TickStatistics (unsigned windowSize = DEFAULT_TICK_STATISTICS_WINDOW_SIZE);
+    virtual ~TickStatistics ();
+
+    void AddSample (float duration);
+    void Clear ();
+
+    unsigned GetSamplesCount () const;
+    unsigned GetWindowSize () const;
+    float GetMin () const;
+    float GetAverage () const;
+    float GetMax () const;
+    /// Sorts copy of samples, so should not be called every tick.
+    float GetPercentile (float percentile) const;
+
+    void SaveToJSON (Urho3D::JSONValue &output) const;
+
+private:
+    Urho3D::PODVector <float> samples_;
+    unsigned windowSize_;
+    unsigned nextSampleIndex_;
+};
+}
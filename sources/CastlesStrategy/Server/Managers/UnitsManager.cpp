@@ -1,4 +1,5 @@
 #include "UnitsManager.hpp"
+#include <Urho3D/Container/Sort.h>
 #include <Urho3D/Scene/Node.h>
 #include <Urho3D/Scene/Scene.h>
 
@@ -15,16 +16,38 @@
 
 namespace CastlesStrategy
 {
+void DecideUnitsCommandsWork (const Urho3D::WorkItem *item, unsigned threadIndex);
+
 void ProcessUnitCommandMoveOrFollow (
-        UnitsManager *unitsManager, Unit *unit, const UnitCommand &command, const UnitType &unitType);
+        UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
 
 void ProcessUnitCommandAttackUnit (
-        UnitsManager *unitsManager, Unit *unit, const UnitCommand &command, const UnitType &unitType);
+        UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
 
 UnitsManager::UnitsManager (ManagersHub *managersHub) : Manager (managersHub),
     spawnsUnitType_ (0),
-    units_ (),
     unitsTypes_ (),
+    aiWakeRadii_ (),
+    aiTick_ (0),
+    unitsState_ (),
+    unitsSlots_ (),
+    unitsHandlesById_ (),
+    unitsCommands_ (),
+    teamsUnits_ (TEAMS_COUNT),
+    teamsGrids_ (TEAMS_COUNT),
+    spawnsHandles_ (),
+    unitsGridMapSize_ (),
+    newUnitsIndices_ (),
+    unitsVisibility_ (),
+
+    crowdRetargetTolerance_ (DEFAULT_CROWD_RETARGET_TOLERANCE),
+    crowdRetargetsIssued_ (0),
+    crowdRetargetsSkipped_ (0),
+
+    unitsPools_ (),
+    unitsPoolHits_ (0),
+    unitsPoolMisses_ (0),
+    randomSeed_ (1),
     unitCommandProcessors_ (UCT_COMMANDS_COUNT)
 {
     unitCommandProcessors_ [UCT_FOLLOW_UNIT] = ProcessUnitCommandMoveOrFollow;
@@ -39,26 +62,41 @@ UnitsManager::~UnitsManager ()
 
 void UnitsManager::AddUnit (Unit *unit)
 {
-    if (!units_.Empty () && units_.Back ()->GetID () >= unit->GetID ())
+    if (unitsHandlesById_.Contains (unit->GetID ()))
     {
         throw UniversalException <UnitsManager> ("UnitsManager: attempt to add the same unit twice!");
     }
 
-    units_.Push (unit);
-    SetupUnit (unit);
+    Urho3D::CrowdAgent *crowdAgent = SetupUnit (unit);
+    unsigned handle = unitsSlots_.Allocate (unitsState_.Size ());
+    unsigned index = unitsState_.Push (unit, crowdAgent, handle);
+    unitsHandlesById_ [unit->GetID ()] = handle;
+
+    unsigned team = GetTeamIndex (unitsState_.belongsToFirst_ [index]);
+    teamsUnits_ [team].Push (index);
+    teamsGrids_ [team].Insert (index, unitsState_.positions_ [index]);
+    // Enemies can not see new unit until next visibility update.
+    unitsVisibility_.Resize (unitsState_.Size ());
+    unitsVisibility_ [index] = GetOwnTeamVisibility (index);
+
+    // Only first spawn of route and team is used, like it was with linear search.
+    unsigned spawnKey = GetSpawnKey (unitsState_.routeIndices_ [index], unitsState_.belongsToFirst_ [index]);
+    if (unitsState_.unitTypes_ [index] == spawnsUnitType_ && !spawnsHandles_.Contains (spawnKey))
+    {
+        spawnsHandles_ [spawnKey] = handle;
+    }
 }
 
 const Unit *UnitsManager::GetSpawn (unsigned route, bool belongsToFirst) const
 {
-    for (const Unit *unit : units_)
+    auto iterator = spawnsHandles_.Find (GetSpawnKey (route, belongsToFirst));
+    if (iterator == spawnsHandles_.End ())
     {
-        if (unit->GetUnitType () == spawnsUnitType_ && unit->GetRouteIndex () == route &&
-            unit->IsBelongsToFirst () == belongsToFirst)
-        {
-            return unit;
-        }
+        return nullptr;
     }
-    return nullptr;
+
+    unsigned index = unitsSlots_.Resolve (iterator->second_);
+    return index != Urho3D::M_MAX_UNSIGNED ? unitsState_.units_ [index] : nullptr;
 }
 
 const Unit *UnitsManager::SpawnUnit (unsigned route, bool belongsToFirst, unsigned unitType)
@@ -93,59 +131,122 @@ const Unit *UnitsManager::SpawnUnit (unsigned spawnId, unsigned unitType)
 
 const Unit *UnitsManager::GetUnit (unsigned int id) const
 {
-    bool found;
-    unsigned index = GetUnitIndex (id, found);
-    return found ? units_ [index] : nullptr;
+    unsigned index = GetUnitIndexById (id);
+    return index != Urho3D::M_MAX_UNSIGNED ? unitsState_.units_ [index] : nullptr;
 }
 
 Unit *UnitsManager::GetUnit (unsigned int id)
 {
-    bool found;
-    unsigned index = GetUnitIndex (id, found);
-    return found ? units_ [index] : nullptr;
+    unsigned index = GetUnitIndexById (id);
+    return index != Urho3D::M_MAX_UNSIGNED ? unitsState_.units_ [index] : nullptr;
 }
 
-const Unit *UnitsManager::GetNearestEnemy (Unit *unit) const
+const UnitsState &UnitsManager::GetUnitsState () const
 {
-    float minimumDistance = INT_MAX;
-    const Unit *nearestEnemy = nullptr;
+    return unitsState_;
+}
 
-    for (const Unit *scanningUnit : units_)
-    {
-        if (unit->IsBelongsToFirst () != scanningUnit->IsBelongsToFirst ())
-        {
-            float distance = (unit->GetNode ()->GetWorldPosition () - scanningUnit->GetNode ()->GetWorldPosition ()).Length ();
-            if (distance < minimumDistance)
-            {
-                minimumDistance = distance;
-                nearestEnemy = scanningUnit;
-            }
-        }
-    }
+unsigned UnitsManager::GetUnitIndexByHandle (unsigned handle) const
+{
+    return unitsSlots_.Resolve (handle);
+}
 
-    return nearestEnemy;
+unsigned UnitsManager::GetNearestEnemy (unsigned unitIndex) const
+{
+    return teamsGrids_ [GetTeamIndex (!unitsState_.belongsToFirst_ [unitIndex])].GetNearest (
+            unitsState_.positions_ [unitIndex]);
 }
 
 Urho3D::PODVector <const Unit *> UnitsManager::GetUnitsNear (Urho3D::Vector2 position, float radius) const
 {
-    Urho3D::PODVector <const Unit *> unitsNear;
-    for (Unit *unit : units_)
+    Urho3D::PODVector <unsigned> indices;
+    for (const UnitsSpatialGrid &teamGrid : teamsGrids_)
     {
-        Urho3D::Vector3 unitPosition3D = unit->GetNode ()->GetPosition ();
-        Urho3D::Vector2 unitPosition = {unitPosition3D.x_, unitPosition3D.z_};
+        teamGrid.CollectUnitsNear (position, radius, indices);
+    }
+    Urho3D::Sort (indices.Begin (), indices.End ());
 
-        if ((unitPosition - position).Length () <= radius)
-        {
-            unitsNear.Push (unit);
-        }
+    Urho3D::PODVector <const Unit *> unitsNear;
+    unitsNear.Reserve (indices.Size ());
+    for (unsigned index : indices)
+    {
+        unitsNear.Push (unitsState_.units_ [index]);
     }
     return unitsNear;
 }
 
 void UnitsManager::HandleUpdate (float timeStep)
 {
+    unitsState_.ReadPositions ();
+    RebuildUnitsGrid ();
     ProcessUnits (timeStep);
+    unitsState_.WriteBackAll ();
+
     ClearDeadUnits ();
+    UpdateTeamsVisibility ();
+}
+
+bool UnitsManager::IsUnitVisibleForTeam (unsigned unitIndex, bool forFirst) const
+{
+    if (unitIndex >= unitsVisibility_.Size ())
+    {
+        return unitIndex < unitsState_.Size () && unitsState_.belongsToFirst_ [unitIndex] == forFirst;
+    }
+    return (unitsVisibility_ [unitIndex] & (1 << GetTeamIndex (forFirst))) != 0;
+}
+
+float UnitsManager::GetCrowdRetargetTolerance () const
+{
+    return crowdRetargetTolerance_;
+}
+
+void UnitsManager::SetCrowdRetargetTolerance (float crowdRetargetTolerance)
+{
+    if (crowdRetargetTolerance < 0.0f)
+    {
+        throw UniversalException <UnitsManager> ("UnitsManager: crowd retarget tolerance can not be less than 0!");
+    }
+    crowdRetargetTolerance_ = crowdRetargetTolerance;
+}
+
+unsigned UnitsManager::GetCrowdRetargetsIssued () const
+{
+    return crowdRetargetsIssued_;
+}
+
+unsigned UnitsManager::GetCrowdRetargetsSkipped () const
+{
+    return crowdRetargetsSkipped_;
+}
+
+unsigned UnitsManager::GetRandomSeed () const
+{
+    return randomSeed_;
+}
+
+void UnitsManager::SetRandomSeed (unsigned randomSeed)
+{
+    randomSeed_ = randomSeed;
+}
+
+unsigned UnitsManager::GetUnitsPoolHits () const
+{
+    return unitsPoolHits_;
+}
+
+unsigned UnitsManager::GetUnitsPoolMisses () const
+{
+    return unitsPoolMisses_;
+}
+
+unsigned UnitsManager::GetPooledUnitsCount () const
+{
+    unsigned count = 0;
+    for (const Urho3D::Vector <Urho3D::SharedPtr <Urho3D::Node> > &pool : unitsPools_)
+    {
+        count += pool.Size ();
+    }
+    return count;
 }
 
 unsigned int UnitsManager::GetUnitsTypesCount () const
@@ -194,20 +295,37 @@ void UnitsManager::LoadUnitsTypesFromXML (const Urho3D::XMLElement &input)
         element = element.GetNext ("unitType");
         id++;
     }
+
+    // Wake radius must cover both vision range and attack distance to the biggest possible enemy.
+    float maxNavigationRadius = 0.0f;
+    for (const UnitType &unitType : unitsTypes_)
+    {
+        maxNavigationRadius = Urho3D::Max (maxNavigationRadius, unitType.GetNavigationRadius ());
+    }
+
+    unitsPools_.Clear ();
+    unitsPools_.Resize (unitsTypes_.size () * TEAMS_COUNT);
+    aiWakeRadii_.Clear ();
+    for (const UnitType &unitType : unitsTypes_)
+    {
+        aiWakeRadii_.Push (Urho3D::Max (unitType.GetVisionRange () * DEFAULT_AI_WAKE_VISION_RANGE_MULTIPLIER,
+                unitType.GetAttackRange () + unitType.GetNavigationRadius () + maxNavigationRadius));
+    }
 }
 
 void UnitsManager::SaveSpawnsToXML (Urho3D::XMLElement &output) const
 {
-    for (const Unit *unit : units_)
+    for (const auto &spawnHandle : spawnsHandles_)
     {
-        if (unit->GetUnitType () == spawnsUnitType_)
+        unsigned index = unitsSlots_.Resolve (spawnHandle.second_);
+        if (index != Urho3D::M_MAX_UNSIGNED)
         {
             Urho3D::XMLElement newChild = output.CreateChild ("spawn");
-            Urho3D::Vector3 worldPosition = unit->GetNode ()->GetWorldPosition ();
+            Urho3D::Vector3 worldPosition = unitsState_.units_ [index]->GetNode ()->GetWorldPosition ();
 
             newChild.SetVector2 ("position", {worldPosition.x_, worldPosition.z_});
-            newChild.SetBool ("belongsToFirst", unit->IsBelongsToFirst ());
-            newChild.SetUInt ("route", unit->GetRouteIndex ());
+            newChild.SetBool ("belongsToFirst", unitsState_.belongsToFirst_ [index]);
+            newChild.SetUInt ("route", unitsState_.routeIndices_ [index]);
         }
     }
 }
@@ -221,7 +339,7 @@ void UnitsManager::LoadSpawnsFromXML (const Urho3D::XMLElement &input)
                                  element.GetBool ("belongsToFirst"), element.GetUInt ("route"));
         AddUnit (unit);
 
-        unit->GetNode ()->GetComponent <Urho3D::CrowdAgent> ()->SetUpdateNodePosition (false);
+        unitsState_.crowdAgents_.Back ()->SetUpdateNodePosition (false);
         element = element.GetNext ("spawn");
     }
 }
@@ -232,11 +350,11 @@ const Unit *UnitsManager::SpawnUnit (const Unit *spawn, unsigned unitType)
     float deltaX = unitsTypes_ [spawnsUnitType_].GetAttackRange ();
     float deltaZ = deltaX;
 
-    deltaX = Urho3D::Random (unitsTypes_ [spawnsUnitType_].GetNavigationRadius (), deltaX);
-    deltaZ = Urho3D::Random (unitsTypes_ [spawnsUnitType_].GetNavigationRadius (), deltaZ);
+    deltaX = NextRandom (unitsTypes_ [spawnsUnitType_].GetNavigationRadius (), deltaX);
+    deltaZ = NextRandom (unitsTypes_ [spawnsUnitType_].GetNavigationRadius (), deltaZ);
 
-    spawnWorldPosition.x_ += (Urho3D::Random (2) * 2 - 1) * deltaX;
-    spawnWorldPosition.z_ += (Urho3D::Random (2) * 2 - 1) * deltaZ;
+    spawnWorldPosition.x_ += (NextRandom () % 2 * 2 - 1) * deltaX;
+    spawnWorldPosition.z_ += (NextRandom () % 2 * 2 - 1) * deltaZ;
 
     Unit *unit = CreateUnit ({spawnWorldPosition.x_, spawnWorldPosition.z_}, unitType,
                              spawn->IsBelongsToFirst (), spawn->GetRouteIndex ());
@@ -245,74 +363,240 @@ const Unit *UnitsManager::SpawnUnit (const Unit *spawn, unsigned unitType)
     return unit;
 }
 
-unsigned UnitsManager::GetUnitIndex (unsigned id, bool &found) const
+unsigned UnitsManager::GetUnitIndexById (unsigned id) const
 {
-    unsigned int left = 0;
-    unsigned int right = units_.Size () - 1;
+    auto iterator = unitsHandlesById_.Find (id);
+    return iterator != unitsHandlesById_.End () ? unitsSlots_.Resolve (iterator->second_) : Urho3D::M_MAX_UNSIGNED;
+}
 
-    while (left <= right)
-    {
-        unsigned int medium = left + (right - left) / 2;
-        Unit *unit = units_ [medium];
+void UnitsManager::ProcessUnits (float timeStep)
+{
+    PrepareUnitsAIInput ();
+    DecideAllUnitsCommands ();
+    aiTick_++;
 
-        if (unit->GetID () == id)
+    crowdRetargetsIssued_ = 0;
+    crowdRetargetsSkipped_ = 0;
+
+    // Commands are applied in units order, so result does not depend on count of threads used to decide them.
+    for (unsigned index = 0; index < unitsState_.Size (); index++)
+    {
+        if (unitsState_.hp_ [index] > 0)
         {
-            found = true;
-            return medium;
+            // Cooldown decrease is not replicated, it is written to unit only together with attack.
+            float &attackCooldown = unitsState_.attackCooldowns_ [index];
+            attackCooldown = Urho3D::Max (0.0f, attackCooldown - timeStep);
+            ProcessUnitCommand (index, unitsCommands_ [index], unitsTypes_ [unitsState_.unitTypes_ [index]]);
         }
-        else if (unit->GetID () > id)
+    }
+}
+
+void UnitsManager::PrepareUnitsAIInput ()
+{
+    const Map *map = dynamic_cast <const Map *> (GetManagersHub ()->GetManager (MI_MAP));
+    for (unsigned index = 0; index < unitsState_.Size (); index++)
+    {
+        unsigned unitTypeIndex = unitsState_.unitTypes_ [index];
+        if (unitTypeIndex >= unitsTypes_.size ())
         {
-            right = medium - 1;
+            throw UniversalException <UnitsManager> (
+                    "UnitsManager: there is only " + Urho3D::String (unitsTypes_.size ()) +
+                    " units types, but T" + Urho3D::String (unitTypeIndex) + " requested!");
         }
-        else
+
+        if (unitsState_.hp_ [index] > 0)
         {
-            left = medium + 1;
+            unitsState_.currentWaypointTargets_ [index] = map->GetProjectedWaypoint (unitsState_.routeIndices_ [index],
+                    unitsState_.currentWaypointIndices_ [index], unitsState_.belongsToFirst_ [index]);
         }
     }
+}
 
-    found = false;
-    return 0;
+bool UnitsManager::IsUnitIdle (unsigned unitIndex, const UnitType &unitType) const
+{
+    const Urho3D::Vector3 &position = unitsState_.positions_ [unitIndex];
+    return (position - unitsState_.currentWaypointTargets_ [unitIndex]).Length () >= unitType.GetAttackRange () &&
+            !teamsGrids_ [GetTeamIndex (!unitsState_.belongsToFirst_ [unitIndex])].HasUnitNear (
+                    position, aiWakeRadii_ [unitsState_.unitTypes_ [unitIndex]]);
 }
 
-void UnitsManager::ProcessUnits (float timeStep)
+void UnitsManager::DecideUnitsCommands (unsigned begin, unsigned end)
 {
-    for (unsigned index = 0; index < units_.Size (); index++)
+    for (unsigned index = begin; index < end; index++)
     {
-        Unit *unit = units_ [index];
-        if (unit->GetHp () > 0)
+        if (unitsState_.hp_ [index] > 0)
         {
-            unit->UpdateCooldowns (timeStep);
+            const UnitType &unitType = unitsTypes_ [unitsState_.unitTypes_ [index]];
+            // Idle units fully rethink only once per interval, staggered by ID, and keep moving to waypoint otherwise.
+            bool isRethinkTick = (aiTick_ + unitsState_.units_ [index]->GetID ()) % DEFAULT_AI_IDLE_RETHINK_INTERVAL == 0;
 
-            if (unit->GetUnitType () >= unitsTypes_.size ())
+            if (!isRethinkTick && IsUnitIdle (index, unitType))
             {
-                throw UniversalException <UnitsManager> (
-                        "UnitsManager: there is only " + Urho3D::String (unitsTypes_.size ()) +
-                        " units types, but T" + Urho3D::String (unit->GetUnitType ()) + " requested!");
+                unitsCommands_ [index] = {UCT_MOVE_TO_WAYPOINT, unitsState_.currentWaypointIndices_ [index]};
+            }
+            else
+            {
+                unitsCommands_ [index] = unitType.GetAiProcessor () (index, unitType, GetManagersHub ());
             }
-
-            const UnitType &unitType = unitsTypes_ [unit->GetUnitType ()];
-            UnitCommand command = unitType.GetAiProcessor () (unit, unitType, GetManagersHub ());
-            ProcessUnitCommand (unit, command, unitType);
         }
     }
 }
 
+void UnitsManager::DecideAllUnitsCommands ()
+{
+    unsigned unitsCount = unitsState_.Size ();
+    unitsCommands_.assign (unitsCount, UnitCommand (UCT_MOVE_TO_WAYPOINT, 0));
+    Urho3D::WorkQueue *workQueue = GetManagersHub ()->GetScene ()->GetSubsystem <Urho3D::WorkQueue> ();
+
+    if (workQueue == nullptr || workQueue->GetNumThreads () == 0 || unitsCount <= DEFAULT_AI_UNITS_PER_WORK_ITEM)
+    {
+        DecideUnitsCommands (0, unitsCount);
+        return;
+    }
+
+    for (unsigned begin = 0; begin < unitsCount; begin += DEFAULT_AI_UNITS_PER_WORK_ITEM)
+    {
+        Urho3D::SharedPtr <Urho3D::WorkItem> item = workQueue->GetFreeItem ();
+        item->priority_ = Urho3D::M_MAX_UNSIGNED;
+        item->workFunction_ = DecideUnitsCommandsWork;
+        item->aux_ = this;
+
+        item->start_ = unitsCommands_.data () + begin;
+        item->end_ = unitsCommands_.data () + Urho3D::Min (begin + DEFAULT_AI_UNITS_PER_WORK_ITEM, unitsCount);
+        workQueue->AddWorkItem (item);
+    }
+    workQueue->Complete (Urho3D::M_MAX_UNSIGNED);
+}
+
 void UnitsManager::ClearDeadUnits ()
 {
     unsigned offset = 0;
-    for (unsigned index = 0; index < units_.Size (); index++)
+    newUnitsIndices_.Resize (unitsState_.Size ());
+
+    for (unsigned index = 0; index < unitsState_.Size (); index++)
     {
-        if (units_ [index]->GetHp () == 0)
+        newUnitsIndices_ [index] = index - offset;
+        if (unitsState_.hp_ [index] == 0)
         {
-            MakeUnitDead (units_ [index]);
+            newUnitsIndices_ [index] = Urho3D::M_MAX_UNSIGNED;
+            unsigned spawnKey = GetSpawnKey (unitsState_.routeIndices_ [index], unitsState_.belongsToFirst_ [index]);
+            auto spawnIterator = spawnsHandles_.Find (spawnKey);
+            if (spawnIterator != spawnsHandles_.End () && spawnIterator->second_ == unitsState_.handles_ [index])
+            {
+                spawnsHandles_.Erase (spawnIterator);
+            }
+
+            unitsSlots_.Release (unitsState_.handles_ [index]);
+            unitsHandlesById_.Erase (unitsState_.units_ [index]->GetID ());
+            MakeUnitDead (index);
             offset++;
         }
         else if (offset > 0)
         {
-            units_ [index - offset] = units_ [index];
+            unitsSlots_.Relocate (unitsState_.handles_ [index], index - offset);
+            unitsState_.Move (index, index - offset);
+        }
+    }
+    unitsState_.Resize (unitsState_.Size () - offset);
+
+    if (offset > 0)
+    {
+        RebuildTeamsUnits ();
+        // Positions are not changed since grids were built, so grids are only remapped to new indices.
+        for (UnitsSpatialGrid &teamGrid : teamsGrids_)
+        {
+            teamGrid.RemapUnits (newUnitsIndices_);
+        }
+    }
+}
+
+void UnitsManager::RebuildUnitsGrid ()
+{
+    const Map *map = dynamic_cast <const Map *> (GetManagersHub ()->GetManager (MI_MAP));
+    Urho3D::Vector2 mapSize (map->GetSize ().x_, map->GetSize ().y_);
+
+    bool mapSizeChanged = mapSize != unitsGridMapSize_;
+    unitsGridMapSize_ = mapSize;
+
+    for (unsigned team = 0; team < TEAMS_COUNT; team++)
+    {
+        UnitsSpatialGrid &teamGrid = teamsGrids_ [team];
+        if (mapSizeChanged)
+        {
+            teamGrid.Setup (mapSize, DEFAULT_UNITS_SPATIAL_GRID_CELL_SIZE);
+        }
+        else
+        {
+            teamGrid.Clear ();
+        }
+
+        for (unsigned index : teamsUnits_ [team])
+        {
+            teamGrid.Insert (index, unitsState_.positions_ [index]);
         }
     }
-    units_.Resize (units_.Size () - offset);
+}
+
+void UnitsManager::RebuildTeamsUnits ()
+{
+    for (Urho3D::PODVector <unsigned> &teamUnits : teamsUnits_)
+    {
+        teamUnits.Clear ();
+    }
+
+    for (unsigned index = 0; index < unitsState_.Size (); index++)
+    {
+        teamsUnits_ [GetTeamIndex (unitsState_.belongsToFirst_ [index])].Push (index);
+    }
+}
+
+void UnitsManager::UpdateTeamsVisibility ()
+{
+    unitsVisibility_.Resize (unitsState_.Size ());
+    for (unsigned index = 0; index < unitsState_.Size (); index++)
+    {
+        unitsVisibility_ [index] = GetOwnTeamVisibility (index);
+    }
+
+    Urho3D::PODVector <unsigned> visibleEnemies;
+    for (unsigned team = 0; team < TEAMS_COUNT; team++)
+    {
+        const UnitsSpatialGrid &enemiesGrid = teamsGrids_ [TEAMS_COUNT - 1 - team];
+        for (unsigned index : teamsUnits_ [team])
+        {
+            const Urho3D::Vector3 &position = unitsState_.positions_ [index];
+            visibleEnemies.Clear ();
+            enemiesGrid.CollectUnitsNear ({position.x_, position.z_},
+                    unitsTypes_ [unitsState_.unitTypes_ [index]].GetVisionRange (), visibleEnemies);
+
+            for (unsigned enemyIndex : visibleEnemies)
+            {
+                unitsVisibility_ [enemyIndex] |= 1 << team;
+            }
+        }
+    }
+}
+
+unsigned char UnitsManager::GetOwnTeamVisibility (unsigned unitIndex) const
+{
+    const unsigned char allTeamsMask = (1 << TEAMS_COUNT) - 1;
+    return unitsState_.unitTypes_ [unitIndex] == spawnsUnitType_ ?
+            allTeamsMask : static_cast <unsigned char> (1 << GetTeamIndex (unitsState_.belongsToFirst_ [unitIndex]));
+}
+
+unsigned UnitsManager::GetTeamIndex (bool belongsToFirst)
+{
+    return belongsToFirst ? 0 : 1;
+}
+
+unsigned UnitsManager::GetSpawnKey (unsigned route, bool belongsToFirst)
+{
+    return route * TEAMS_COUNT + GetTeamIndex (belongsToFirst);
+}
+
+unsigned UnitsManager::GetPoolIndex (unsigned unitType, bool belongsToFirst)
+{
+    return unitType * TEAMS_COUNT + GetTeamIndex (belongsToFirst);
 }
 
 Unit *UnitsManager::CreateUnit (Urho3D::Vector2 position, unsigned unitType, bool belongsToFirst, unsigned route)
@@ -324,22 +608,54 @@ Unit *UnitsManager::CreateUnit (Urho3D::Vector2 position, unsigned unitType, boo
     }
 
     Urho3D::NavigationMesh *navigationMesh = GetManagersHub ()->GetScene ()->GetComponent <Urho3D::NavigationMesh> ();
-    Urho3D::Node *unitNode = unitsNode->CreateChild (Urho3D::String::EMPTY, Urho3D::REPLICATED);
-    unitNode->SetWorldPosition (
-            navigationMesh->FindNearestPoint ({position.x_, 0.0f, position.y_}, Urho3D::Vector3::UP * INT_MAX));
+    Urho3D::Vector3 worldPosition =
+            navigationMesh->FindNearestPoint ({position.x_, 0.0f, position.y_}, Urho3D::Vector3::UP * INT_MAX);
+    Unit *unit = TakeUnitFromPool (unitType, belongsToFirst);
+
+    if (unit != nullptr)
+    {
+        // Node is enabled after position change, so crowd agent is added to crowd at new position.
+        unit->GetNode ()->SetWorldPosition (worldPosition);
+        unit->GetNode ()->SetEnabled (true);
+        unitsPoolHits_++;
+    }
+    else
+    {
+        Urho3D::Node *unitNode = unitsNode->CreateChild (Urho3D::String::EMPTY, Urho3D::REPLICATED);
+        unitNode->SetWorldPosition (worldPosition);
+        unit = unitNode->CreateComponent <Unit> (Urho3D::REPLICATED);
+        unitsPoolMisses_++;
+    }
 
-    Unit *unit = unitNode->CreateComponent <Unit> (Urho3D::REPLICATED);
     unit->SetUnitType (unitType);
     unit->SetBelongsToFirst (belongsToFirst);
     unit->SetRouteIndex (route);
     return unit;
 }
 
-void UnitsManager::SetupUnit (Unit *unit)
+Unit *UnitsManager::TakeUnitFromPool (unsigned unitType, bool belongsToFirst)
+{
+    unsigned poolIndex = GetPoolIndex (unitType, belongsToFirst);
+    if (poolIndex >= unitsPools_.Size () || unitsPools_ [poolIndex].Empty ())
+    {
+        return nullptr;
+    }
+
+    Urho3D::SharedPtr <Urho3D::Node> unitNode = unitsPools_ [poolIndex].Back ();
+    unitsPools_ [poolIndex].Pop ();
+    return unitNode->GetComponent <Unit> ();
+}
+
+Urho3D::CrowdAgent *UnitsManager::SetupUnit (Unit *unit)
 {
     const UnitType &unitType = GetUnitType (unit->GetUnitType ());
     unit->GetNode ()->SetVar (UNIT_PREFAB_VAR_HASH, unitType.GetPrefabPath ());
-    Urho3D::CrowdAgent *crowdAgent = unit->GetNode ()->CreateComponent <Urho3D::CrowdAgent> (Urho3D::LOCAL);
+    Urho3D::CrowdAgent *crowdAgent = unit->GetNode ()->GetComponent <Urho3D::CrowdAgent> ();
+
+    if (crowdAgent == nullptr)
+    {
+        crowdAgent = unit->GetNode ()->CreateComponent <Urho3D::CrowdAgent> (Urho3D::LOCAL);
+    }
 
     crowdAgent->SetMaxSpeed (unitType.GetMoveSpeed ());
     crowdAgent->SetMaxAccel (INT_MAX);
@@ -348,82 +664,148 @@ void UnitsManager::SetupUnit (Unit *unit)
     unit->SetHp (unitType.GetMaxHp ());
     unit->SetAttackCooldown (0.0f);
     unit->SetCurrentWaypointIndex (0);
+    return crowdAgent;
 }
 
-void UnitsManager::ProcessUnitCommand (Unit *unit, const UnitCommand &command, const UnitType &unitType)
+void UnitsManager::ProcessUnitCommand (unsigned unitIndex, const UnitCommand &command, const UnitType &unitType)
 {
-    unitCommandProcessors_ [command.commandType_] (this, unit, command, unitType);
+    unitCommandProcessors_ [command.commandType_] (this, unitIndex, command, unitType);
 }
 
-void UnitsManager::MakeUnitDead (Unit *unit)
+void UnitsManager::MakeUnitDead (unsigned unitIndex)
 {
-    if (unit->GetUnitType () == spawnsUnitType_)
+    Unit *unit = unitsState_.units_ [unitIndex];
+    if (unitsState_.unitTypes_ [unitIndex] == spawnsUnitType_)
     {
         Urho3D::VariantMap eventData;
-        eventData [GameEnded::FIRST_WON] = !unit->IsBelongsToFirst ();
+        eventData [GameEnded::FIRST_WON] = !unitsState_.belongsToFirst_ [unitIndex];
         GetManagersHub ()->GetScene ()->SendEvent (E_GAME_ENDED, eventData);
     }
 
-    // TODO: Temporary (reimplement).
-    unit->GetNode ()->Remove ();
+    unsigned poolIndex = GetPoolIndex (unitsState_.unitTypes_ [unitIndex], unitsState_.belongsToFirst_ [unitIndex]);
+    if (poolIndex < unitsPools_.Size () && unitsPools_ [poolIndex].Size () < DEFAULT_UNITS_POOL_MAX_SIZE)
+    {
+        // Disabled node removes its crowd agent from crowd and is replicated to clients as disabled.
+        unit->GetNode ()->SetEnabled (false);
+        unitsPools_ [poolIndex].Push (Urho3D::SharedPtr <Urho3D::Node> (unit->GetNode ()));
+    }
+    else
+    {
+        unit->GetNode ()->Remove ();
+    }
 }
 
-void ProcessUnitCommandMoveOrFollow (UnitsManager *unitsManager, Unit *unit, const UnitCommand &command,
+void DecideUnitsCommandsWork (const Urho3D::WorkItem *item, unsigned threadIndex)
+{
+    UnitsManager *unitsManager = static_cast <UnitsManager *> (item->aux_);
+    const UnitCommand *commands = unitsManager->unitsCommands_.data ();
+    unitsManager->DecideUnitsCommands (static_cast <const UnitCommand *> (item->start_) - commands,
+            static_cast <const UnitCommand *> (item->end_) - commands);
+}
+
+bool UnitsManager::UpdateCrowdTarget (unsigned unitIndex, UnitCommandType commandType, const Urho3D::Vector3 &target)
+{
+    if (unitsState_.lastCrowdCommandTypes_ [unitIndex] == commandType &&
+            (unitsState_.lastCrowdTargets_ [unitIndex] - target).Length () <= crowdRetargetTolerance_)
+    {
+        crowdRetargetsSkipped_++;
+        return false;
+    }
+
+    unitsState_.lastCrowdCommandTypes_ [unitIndex] = commandType;
+    unitsState_.lastCrowdTargets_ [unitIndex] = target;
+    crowdRetargetsIssued_++;
+    return true;
+}
+
+int UnitsManager::NextRandom ()
+{
+    randomSeed_ = randomSeed_ * 214013 + 2531011;
+    return (randomSeed_ >> 16) & 32767;
+}
+
+float UnitsManager::NextRandom (float min, float max)
+{
+    return min + NextRandom () * (max - min) / 32767.0f;
+}
+
+void ProcessUnitCommandMoveOrFollow (UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command,
                                      const UnitType &unitType)
 {
+    UnitsState &unitsState = unitsManager->unitsState_;
     Urho3D::Vector3 target;
+
     if (command.commandType_ == UCT_MOVE_TO_WAYPOINT)
     {
+        if (unitsState.currentWaypointIndices_ [unitIndex] != command.argument_)
+        {
+            unitsState.currentWaypointIndices_ [unitIndex] = command.argument_;
+            unitsState.dirtyFlags_ [unitIndex] |= USDF_CURRENT_WAYPOINT_INDEX;
+        }
+
         const Map *map = dynamic_cast <const Map *> (unitsManager->GetManagersHub ()->GetManager (MI_MAP));
-        Urho3D::Vector2 nextWaypoint = map->GetWaypoint (
-                unit->GetRouteIndex (), unit->GetCurrentWaypointIndex (), unit->IsBelongsToFirst ());
-        target = {nextWaypoint.x_, 0.0f, nextWaypoint.y_};
+        target = map->GetProjectedWaypoint (unitsState.routeIndices_ [unitIndex],
+                command.argument_, unitsState.belongsToFirst_ [unitIndex]);
+
+        if (!unitsManager->UpdateCrowdTarget (unitIndex, command.commandType_, target))
+        {
+            return;
+        }
     }
     else
     {
-        Unit *another = unitsManager->GetUnit (command.argument_);
-        if (another == nullptr)
+        unsigned anotherIndex = unitsManager->GetUnitIndexByHandle (command.argument_);
+        if (anotherIndex == Urho3D::M_MAX_UNSIGNED)
         {
-            throw UniversalException <UnitsManager> ("UnitsManager: unit " + Urho3D::String (command.argument_) +
-                                                     " does not exists, can not follow! AI error?");
+            return;
+        }
+
+        // Followed unit position is compared before projection, so skipped retarget does not query navigation mesh.
+        if (!unitsManager->UpdateCrowdTarget (unitIndex, command.commandType_, unitsState.positions_ [anotherIndex]))
+        {
+            return;
         }
-        target = another->GetNode ()->GetWorldPosition ();
-    }
 
-    target = unit->GetScene ()->GetComponent <Urho3D::NavigationMesh> ()->FindNearestPoint (target,
-                                                                                            Urho3D::Vector3 (1.0f, INT_MAX, 1.0f));
+        target = unitsManager->GetManagersHub ()->GetScene ()->GetComponent <Urho3D::NavigationMesh> ()->FindNearestPoint (
+                unitsState.positions_ [anotherIndex], Urho3D::Vector3 (1.0f, INT_MAX, 1.0f));
+    }
 
-    Urho3D::CrowdAgent *crowdAgent = unit->GetNode ()->GetComponent <Urho3D::CrowdAgent> ();
-    crowdAgent->SetTargetPosition (target);
+    unitsState.crowdAgents_ [unitIndex]->SetTargetPosition (target);
 }
 
-void ProcessUnitCommandAttackUnit (UnitsManager *unitsManager, Unit *unit, const UnitCommand &command,
+void ProcessUnitCommandAttackUnit (UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command,
                                    const UnitType &unitType)
 {
-    Urho3D::CrowdAgent *crowdAgent = unit->GetNode ()->GetComponent <Urho3D::CrowdAgent> ();
-    crowdAgent->SetTargetVelocity (Urho3D::Vector3::ZERO);
+    UnitsState &unitsState = unitsManager->unitsState_;
+    unsigned anotherIndex = unitsManager->GetUnitIndexByHandle (command.argument_);
+    if (anotherIndex == Urho3D::M_MAX_UNSIGNED)
+    {
+        return;
+    }
 
-    Unit *another = unitsManager->GetUnit (command.argument_);
-    if (another == nullptr)
+    if (unitsManager->UpdateCrowdTarget (unitIndex, command.commandType_, Urho3D::Vector3::ZERO))
     {
-        throw UniversalException <UnitsManager> ("UnitsManager: unit " + Urho3D::String (command.argument_) +
-                                                 " does not exists, can not attack! AI error?");
+        unitsState.crowdAgents_ [unitIndex]->SetTargetVelocity (Urho3D::Vector3::ZERO);
     }
 
-    const UnitType &anotherUnitType = unitsManager->GetUnitType (another->GetUnitType ());
-    if ((unit->GetNode ()->GetWorldPosition () - another->GetNode ()->GetWorldPosition ()).Length () >
+    const UnitType &anotherUnitType = unitsManager->GetUnitType (unitsState.unitTypes_ [anotherIndex]);
+    if ((unitsState.positions_ [unitIndex] - unitsState.positions_ [anotherIndex]).Length () >
         anotherUnitType.GetNavigationRadius () + unitType.GetAttackRange () + unitType.GetNavigationRadius ())
     {
-        throw UniversalException <UnitsManager> ("UnitsManager: unit " + Urho3D::String (command.argument_) +
-                                                 " is too far, can not attack! AI error?");
+        throw UniversalException <UnitsManager> ("UnitsManager: unit " +
+                Urho3D::String (unitsState.units_ [anotherIndex]->GetID ()) + " is too far, can not attack! AI error?");
     }
 
-    if (unit->GetAttackCooldown () <= 0.0f)
+    if (unitsState.attackCooldowns_ [unitIndex] <= 0.0f)
     {
-        float attackModifier = unitType.GetAttackModiferVersus (another->GetUnitType ());
-        another->SetHp (static_cast <unsigned int> (another->GetHp () > unitType.GetAttackForce () * attackModifier ?
-                        another->GetHp () - unitType.GetAttackForce () * attackModifier : 0));
-        unit->SetAttackCooldown (unitType.GetAttackSpeed ());
+        unsigned &anotherHp = unitsState.hp_ [anotherIndex];
+        float attackModifier = unitType.GetAttackModiferVersus (unitsState.unitTypes_ [anotherIndex]);
+        anotherHp = static_cast <unsigned int> (anotherHp > unitType.GetAttackForce () * attackModifier ?
+                anotherHp - unitType.GetAttackForce () * attackModifier : 0);
+
+        unitsState.dirtyFlags_ [anotherIndex] |= USDF_HP;
+        unitsState.attackCooldowns_ [unitIndex] = unitType.GetAttackSpeed ();
+        unitsState.dirtyFlags_ [unitIndex] |= USDF_ATTACK_COOLDOWN;
     }
 }
 }
@@ -1,14 +1,27 @@
 #pragma once
 #include <vector>
+#include <Urho3D/Container/HashMap.h>
 #include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Scene/Node.h>
 
 #include <CastlesStrategy/Server/Managers/Manager.hpp>
+#include <CastlesStrategy/Server/Unit/UnitsSpatialGrid.hpp>
+#include <CastlesStrategy/Server/Unit/UnitsState.hpp>
 #include <CastlesStrategy/Shared/Network/GameStatus.hpp>
 #include <CastlesStrategy/Shared/Unit/Unit.hpp>
 #include <CastlesStrategy/Shared/Unit/UnitType.hpp>
+#include <Utils/SlotMap.hpp>
 
 namespace CastlesStrategy
 {
+const unsigned DEFAULT_AI_UNITS_PER_WORK_ITEM = 64;
+const float DEFAULT_AI_WAKE_VISION_RANGE_MULTIPLIER = 1.5f;
+const unsigned DEFAULT_AI_IDLE_RETHINK_INTERVAL = 8;
+const float DEFAULT_CROWD_RETARGET_TOLERANCE = 0.25f;
+const unsigned DEFAULT_UNITS_POOL_MAX_SIZE = 64;
+const unsigned TEAMS_COUNT = 2;
+
 URHO3D_EVENT (E_GAME_ENDED, GameEnded)
 {
     URHO3D_PARAM (FIRST_WON, FirstWon);
@@ -28,10 +41,38 @@ public:
 
     const Unit *GetUnit (unsigned int id) const;
     Unit *GetUnit (unsigned int id);
-    const Unit *GetNearestEnemy (Unit *unit) const;
+    const UnitsState &GetUnitsState () const;
+    /// Returns dense index of unit with given handle or M_MAX_UNSIGNED if unit is already removed.
+    unsigned GetUnitIndexByHandle (unsigned handle) const;
+
+    /// Returns dense index of nearest enemy or M_MAX_UNSIGNED. Uses units positions captured at the beginning of tick.
+    unsigned GetNearestEnemy (unsigned unitIndex) const;
+    /// Uses units positions captured at the beginning of current tick.
     Urho3D::PODVector <const Unit *> GetUnitsNear (Urho3D::Vector2 position, float radius) const;
 
+    /// Own units and spawns are always visible. Enemy units are visible if they are in vision range of any unit of
+    /// team. Calculated at the end of tick, units added after it are hidden from enemies until next calculation.
+    bool IsUnitVisibleForTeam (unsigned unitIndex, bool forFirst) const;
+
     virtual void HandleUpdate (float timeStep);
+    float GetCrowdRetargetTolerance () const;
+    void SetCrowdRetargetTolerance (float crowdRetargetTolerance);
+
+    /// Count of crowd agents target changes, that were sent to crowd during last tick.
+    unsigned GetCrowdRetargetsIssued () const;
+    /// Count of crowd agents target changes, that were skipped during last tick because target is almost the same.
+    unsigned GetCrowdRetargetsSkipped () const;
+
+    /// Count of units created by reusing disabled node from pool.
+    unsigned GetUnitsPoolHits () const;
+    /// Count of units created with new node because pool of their type was empty.
+    unsigned GetUnitsPoolMisses () const;
+    unsigned GetPooledUnitsCount () const;
+
+    /// Spawn positions are randomized by manager own generator, so they can be repeated with the same seed.
+    unsigned GetRandomSeed () const;
+    void SetRandomSeed (unsigned randomSeed);
+
     unsigned int GetUnitsTypesCount () const;
     const UnitType &GetUnitType (unsigned int index) const;
     unsigned int GetSpawnsUnitType () const;
@@ -44,27 +85,77 @@ public:
 
 private:
     const Unit *SpawnUnit (const Unit *spawn, unsigned unitType);
-    unsigned GetUnitIndex (unsigned id, bool &found) const;
+    unsigned GetUnitIndexById (unsigned id) const;
     void ProcessUnits (float timeStep);
+    void PrepareUnitsAIInput ();
+    /// Idle unit has no enemies in wake radius and is not near its current waypoint, so its AI can only decide
+    /// to continue moving to current waypoint.
+    bool IsUnitIdle (unsigned unitIndex, const UnitType &unitType) const;
+    /// Runs AI of alive units and writes commands to unitsCommands_. Reads units state only, so can be called in parallel.
+    void DecideUnitsCommands (unsigned begin, unsigned end);
+    void DecideAllUnitsCommands ();
     void ClearDeadUnits ();
+    void RebuildUnitsGrid ();
+    void RebuildTeamsUnits ();
+    void UpdateTeamsVisibility ();
+    /// Returns visibility of unit without enemies vision: spawns are visible to all teams, other units to own team.
+    unsigned char GetOwnTeamVisibility (unsigned unitIndex) const;
+
+    static unsigned GetTeamIndex (bool belongsToFirst);
+    static unsigned GetSpawnKey (unsigned route, bool belongsToFirst);
+    static unsigned GetPoolIndex (unsigned unitType, bool belongsToFirst);
 
     Unit *CreateUnit (Urho3D::Vector2 position, unsigned unitType, bool belongsToFirst, unsigned route);
-    void SetupUnit (Unit *unit);
-    void ProcessUnitCommand (Unit *unit, const UnitCommand &command, const UnitType &unitType);
-    void MakeUnitDead (Unit *unit);
+    Unit *TakeUnitFromPool (unsigned unitType, bool belongsToFirst);
+    Urho3D::CrowdAgent *SetupUnit (Unit *unit);
+    void ProcessUnitCommand (unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
+    void MakeUnitDead (unsigned unitIndex);
+    /// Returns true if crowd agent target should be changed and stores new target as last if so.
+    bool UpdateCrowdTarget (unsigned unitIndex, UnitCommandType commandType, const Urho3D::Vector3 &target);
+    /// Same generator as Urho3D::Rand, but with its own state.
+    int NextRandom ();
+    float NextRandom (float min, float max);
+
+    friend void DecideUnitsCommandsWork (const Urho3D::WorkItem *item, unsigned threadIndex);
 
     friend void ProcessUnitCommandMoveOrFollow (
-            UnitsManager *unitsManager, Unit *unit, const UnitCommand &command, const UnitType &unitType);
+            UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
 
     friend void ProcessUnitCommandAttackUnit (
-            UnitsManager *unitsManager, Unit *unit, const UnitCommand &command, const UnitType &unitType);
+            UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
 
     typedef void (*UnitCommandProcessor) (
-            UnitsManager *unitsManager, Unit *unit, const UnitCommand &command, const UnitType &unitType);
+            UnitsManager *unitsManager, unsigned unitIndex, const UnitCommand &command, const UnitType &unitType);
 
     unsigned spawnsUnitType_;
     std::vector <UnitType> unitsTypes_;
-    Urho3D::PODVector <Unit *> units_;
+    Urho3D::PODVector <float> aiWakeRadii_;
+    unsigned aiTick_;
+    UnitsState unitsState_;
+    SlotMap unitsSlots_;
+    Urho3D::HashMap <unsigned, unsigned> unitsHandlesById_;
+    std::vector <UnitCommand> unitsCommands_;
+    /// Dense indices of units of each team, first player team has index 0.
+    Urho3D::Vector <Urho3D::PODVector <unsigned> > teamsUnits_;
+    Urho3D::Vector <UnitsSpatialGrid> teamsGrids_;
+    /// Handles of spawns by spawn key, built from route and team.
+    Urho3D::HashMap <unsigned, unsigned> spawnsHandles_;
+    Urho3D::Vector2 unitsGridMapSize_;
+    /// Dense indices of units after dead units removal by old dense indices, M_MAX_UNSIGNED for dead units.
+    Urho3D::PODVector <unsigned> newUnitsIndices_;
+    /// Bit mask of teams, that see unit, by dense index. Bit index is team index.
+    Urho3D::PODVector <unsigned char> unitsVisibility_;
+
+    float crowdRetargetTolerance_;
+    unsigned crowdRetargetsIssued_;
+    unsigned crowdRetargetsSkipped_;
+
+    /// Disabled nodes of dead units, separated by unit type and team. Nodes stay replicated, so clients keep their
+    /// prefabs, which are built for unit type and team.
+    Urho3D::Vector <Urho3D::Vector <Urho3D::SharedPtr <Urho3D::Node> > > unitsPools_;
+    unsigned unitsPoolHits_;
+    unsigned unitsPoolMisses_;
+    unsigned randomSeed_;
     Urho3D::PODVector <UnitCommandProcessor> unitCommandProcessors_;
 };
 }
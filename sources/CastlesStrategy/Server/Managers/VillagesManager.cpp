@@ -8,7 +8,9 @@ namespace CastlesStrategy
 {
 VillagesManager::VillagesManager (ManagersHub *managersHub) : Manager (managersHub),
     timeUntilTaxes_ (DEFAULT_TAXES_DELAY),
-    villages_ ()
+    villages_ (),
+    villagesSlots_ (),
+    villagesHandlesById_ ()
 {
 
 }
@@ -43,16 +45,14 @@ unsigned int VillagesManager::GetVillagesCount () const
 
 const Village *VillagesManager::GetVillageById (unsigned int id) const
 {
-    bool found;
-    unsigned index = GetVillageIndex (id, found);
-    return found ? villages_ [index] : nullptr;
+    unsigned index = GetVillageIndex (id);
+    return index != Urho3D::M_MAX_UNSIGNED ? villages_ [index] : nullptr;
 }
 
 Village *VillagesManager::GetVillageById (unsigned int id)
 {
-    bool found;
-    unsigned index = GetVillageIndex (id, found);
-    return found ? villages_ [index] : nullptr;
+    unsigned index = GetVillageIndex (id);
+    return index != Urho3D::M_MAX_UNSIGNED ? villages_ [index] : nullptr;
 }
 
 const Urho3D::PODVector <Village *> &VillagesManager::GetVillages () const
@@ -72,6 +72,7 @@ Village *VillagesManager::CreateVillage (const Urho3D::Vector3 &position)
     newVillageNode->SetWorldPosition (position);
 
     Village *newVillage = newVillageNode->CreateComponent <Village> (Urho3D::REPLICATED);
+    villagesHandlesById_ [newVillage->GetID ()] = villagesSlots_.Allocate (villages_.Size ());
     villages_.Push (newVillage);
     return newVillage;
 }
@@ -90,6 +91,8 @@ void VillagesManager::LoadVillagesFromXML (const Urho3D::XMLElement &input)
 {
     Urho3D::XMLElement villageXML = input.GetChild ("village");
     villages_.Clear ();
+    villagesSlots_.Clear ();
+    villagesHandlesById_.Clear ();
 
     while (villageXML.NotNull ())
     {
@@ -99,33 +102,10 @@ void VillagesManager::LoadVillagesFromXML (const Urho3D::XMLElement &input)
     }
 }
 
-unsigned VillagesManager::GetVillageIndex (unsigned id, bool &found) const
+unsigned VillagesManager::GetVillageIndex (unsigned id) const
 {
-    unsigned int left = 0;
-    unsigned int right = villages_.Size () - 1;
-
-    while (left <= right)
-    {
-        unsigned int medium = left + (right - left) / 2;
-        Village *village = villages_ [medium];
-
-        if (village->GetID () == id)
-        {
-            found = true;
-            return medium;
-        }
-        else if (village->GetID () > id)
-        {
-            right = medium - 1;
-        }
-        else
-        {
-            left = medium + 1;
-        }
-    }
-
-    found = false;
-    return 0;
+    auto iterator = villagesHandlesById_.Find (id);
+    return iterator != villagesHandlesById_.End () ? villagesSlots_.Resolve (iterator->second_) : Urho3D::M_MAX_UNSIGNED;
 }
 
 void VillagesManager::UpdateVillagesOwnerships (float timeStep) const
@@ -1,7 +1,9 @@
 #pragma once
 #include <vector>
+#include <Urho3D/Container/HashMap.h>
 #include <CastlesStrategy/Server/Managers/Manager.hpp>
 #include <CastlesStrategy/Shared/Village/Village.hpp>
+#include <Utils/SlotMap.hpp>
 
 namespace CastlesStrategy
 {
@@ -26,11 +28,13 @@ public:
     void LoadVillagesFromXML (const Urho3D::XMLElement &input);
 
 private:
-    unsigned GetVillageIndex (unsigned id, bool &found) const;
+    unsigned GetVillageIndex (unsigned id) const;
     void UpdateVillagesOwnerships (float timeStep) const;
     void ProcessTaxes ();
 
     float timeUntilTaxes_;
     Urho3D::PODVector <Village *> villages_;
+    SlotMap villagesSlots_;
+    Urho3D::HashMap <unsigned, unsigned> villagesHandlesById_;
 };
 }
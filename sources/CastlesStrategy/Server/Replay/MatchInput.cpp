@@ -0,0 +1,29 @@
+#include "MatchInput.hpp"
+#include <CastlesStrategy/Server/Managers/PlayersManager.hpp>
+#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
+#include <CastlesStrategy/Server/Player/Player.hpp>
+#include <Utils/UniversalException.hpp>
+
+namespace CastlesStrategy
+{
+void ApplyMatchInput (ManagersHub *managersHub, const MatchInput &input)
+{
+    PlayersManager *playersManager = dynamic_cast <PlayersManager *> (managersHub->GetManager (MI_PLAYERS_MANAGER));
+    Player &player = input.firstPlayer_ ? playersManager->GetFirstPlayer () : playersManager->GetSecondPlayer ();
+
+    if (input.type_ == MIT_ADD_ORDER)
+    {
+        player.AddOrder (input.unitType_);
+    }
+    else if (input.type_ == MIT_SPAWN_UNIT)
+    {
+        player.TakeUnitFromPull (input.unitType_);
+        UnitsManager *unitsManager = dynamic_cast <UnitsManager *> (managersHub->GetManager (MI_UNITS_MANAGER));
+        unitsManager->SpawnUnit (input.spawnId_, input.unitType_);
+    }
+    else
+    {
+        throw UniversalException <MatchInput> ("MatchInput: unknown input type " + Urho3D::String (input.type_) + "!");
+    }
+}
+}
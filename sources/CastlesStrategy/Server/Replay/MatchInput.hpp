@@ -0,0 +1,26 @@
+#pragma once
+#include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
+
+namespace CastlesStrategy
+{
+enum MatchInputType
+{
+    MIT_ADD_ORDER = 0,
+    MIT_SPAWN_UNIT,
+    MIT_TYPES_COUNT
+};
+
+/// Player input, which changes match simulation. Tick is count of ticks simulated before input is applied.
+struct MatchInput
+{
+    unsigned tick_;
+    MatchInputType type_;
+    bool firstPlayer_;
+    unsigned unitType_;
+    /// Used only by spawn unit input.
+    unsigned spawnId_;
+};
+
+/// Applies input to players and units managers. Used both by network messages processing and by replay.
+void ApplyMatchInput (ManagersHub *managersHub, const MatchInput &input);
+}
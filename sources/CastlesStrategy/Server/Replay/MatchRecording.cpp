@@ -0,0 +1,137 @@
+#include "MatchRecording.hpp"
+#include <Utils/UniversalException.hpp>
+
+namespace CastlesStrategy
+{
+static const char *MATCH_RECORDING_ID = "CSMR";
+
+MatchRecording::MatchRecording () :
+        mapName_ (),
+        randomSeed_ (0),
+        ticksTimeSteps_ (),
+        inputs_ ()
+{
+
+}
+
+MatchRecording::~MatchRecording ()
+{
+
+}
+
+void MatchRecording::Setup (const Urho3D::String &mapName, unsigned randomSeed)
+{
+    Clear ();
+    mapName_ = mapName;
+    randomSeed_ = randomSeed;
+}
+
+void MatchRecording::Clear ()
+{
+    mapName_.Clear ();
+    randomSeed_ = 0;
+    ticksTimeSteps_.Clear ();
+    inputs_.Clear ();
+}
+
+void MatchRecording::AddTick (float timeStep)
+{
+    ticksTimeSteps_.Push (timeStep);
+}
+
+void MatchRecording::AddInput (MatchInput input)
+{
+    input.tick_ = ticksTimeSteps_.Size ();
+    inputs_.Push (input);
+}
+
+const Urho3D::String &MatchRecording::GetMapName () const
+{
+    return mapName_;
+}
+
+unsigned MatchRecording::GetRandomSeed () const
+{
+    return randomSeed_;
+}
+
+unsigned MatchRecording::GetTicksCount () const
+{
+    return ticksTimeSteps_.Size ();
+}
+
+const Urho3D::PODVector <float> &MatchRecording::GetTicksTimeSteps () const
+{
+    return ticksTimeSteps_;
+}
+
+const Urho3D::PODVector <MatchInput> &MatchRecording::GetInputs () const
+{
+    return inputs_;
+}
+
+bool MatchRecording::Save (Urho3D::Serializer &output) const
+{
+    bool success = output.WriteFileID (MATCH_RECORDING_ID);
+    success &= output.WriteUInt (MATCH_RECORDING_VERSION);
+    success &= output.WriteString (mapName_);
+    success &= output.WriteUInt (randomSeed_);
+
+    success &= output.WriteVLE (ticksTimeSteps_.Size ());
+    for (float timeStep : ticksTimeSteps_)
+    {
+        success &= output.WriteFloat (timeStep);
+    }
+
+    success &= output.WriteVLE (inputs_.Size ());
+    for (const MatchInput &input : inputs_)
+    {
+        success &= output.WriteUInt (input.tick_);
+        success &= output.WriteUByte (static_cast <unsigned char> (input.type_));
+        success &= output.WriteBool (input.firstPlayer_);
+        success &= output.WriteUInt (input.unitType_);
+        success &= output.WriteUInt (input.spawnId_);
+    }
+    return success;
+}
+
+void MatchRecording::Load (Urho3D::Deserializer &input)
+{
+    if (input.ReadFileID () != MATCH_RECORDING_ID)
+    {
+        throw UniversalException <MatchRecording> ("MatchRecording: input is not a match recording!");
+    }
+
+    unsigned version = input.ReadUInt ();
+    if (version != MATCH_RECORDING_VERSION)
+    {
+        throw UniversalException <MatchRecording> (
+                "MatchRecording: unsupported recording version " + Urho3D::String (version) + "!");
+    }
+
+    Clear ();
+    mapName_ = input.ReadString ();
+    randomSeed_ = input.ReadUInt ();
+
+    ticksTimeSteps_.Resize (input.ReadVLE ());
+    for (float &timeStep : ticksTimeSteps_)
+    {
+        timeStep = input.ReadFloat ();
+    }
+
+    inputs_.Resize (input.ReadVLE ());
+    for (MatchInput &matchInput : inputs_)
+    {
+        matchInput.tick_ = input.ReadUInt ();
+        matchInput.type_ = static_cast <MatchInputType> (input.ReadUByte ());
+        matchInput.firstPlayer_ = input.ReadBool ();
+        matchInput.unitType_ = input.ReadUInt ();
+        matchInput.spawnId_ = input.ReadUInt ();
+
+        if (matchInput.type_ >= MIT_TYPES_COUNT || matchInput.tick_ > ticksTimeSteps_.Size ())
+        {
+            throw UniversalException <MatchRecording> ("MatchRecording: recording contains broken input!");
+        }
+    }
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Serializer.h>
+#include <CastlesStrategy/Server/Replay/MatchInput.hpp>
+
+namespace CastlesStrategy
+{
+const unsigned MATCH_RECORDING_VERSION = 1;
+
+/// Everything that is needed to repeat match simulation: map, units random seed, time step of each tick and
+/// players inputs with their ticks.
+class MatchRecording
+{
+public:
+    MatchRecording ();
+    virtual ~MatchRecording ();
+
+    void Setup (const Urho3D::String &mapName, unsigned randomSeed);
+    void Clear ();
+    void AddTick (float timeStep);
+    /// Input tick is set to current ticks count.
+    void AddInput (MatchInput input);
+
+    const Urho3D::String &GetMapName () const;
+    unsigned GetRandomSeed () const;
+    unsigned GetTicksCount () const;
+    const Urho3D::PODVector <float> &GetTicksTimeSteps () const;
+    const Urho3D::PODVector <MatchInput> &GetInputs () const;
+
+    bool Save (Urho3D::Serializer &output) const;
+    /// Throws exception if data is not match recording or has unsupported version.
+    void Load (Urho3D::Deserializer &input);
+
+private:
+    Urho3D::String mapName_;
+    unsigned randomSeed_;
+    Urho3D::PODVector <float> ticksTimeSteps_;
+    Urho3D::PODVector <MatchInput> inputs_;
+};
+}
@@ -0,0 +1,190 @@
+#include "UnitsSpatialGrid.hpp"
+#include <climits>
+#include <Urho3D/Container/Sort.h>
+#include <Utils/UniversalException.hpp>
+
+namespace CastlesStrategy
+{
+UnitsSpatialGrid::UnitsSpatialGrid () :
+        cellSize_ (DEFAULT_UNITS_SPATIAL_GRID_CELL_SIZE),
+        cellsCount_ (1, 1),
+        cells_ (1)
+{
+
+}
+
+UnitsSpatialGrid::~UnitsSpatialGrid ()
+{
+
+}
+
+void UnitsSpatialGrid::Setup (const Urho3D::Vector2 &mapSize, float cellSize)
+{
+    if (cellSize <= 0.0f)
+    {
+        throw UniversalException <UnitsSpatialGrid> ("UnitsSpatialGrid: cell size must be more than 0!");
+    }
+
+    cellSize_ = cellSize;
+    cellsCount_.x_ = Urho3D::Max (1, Urho3D::CeilToInt (mapSize.x_ / cellSize_));
+    cellsCount_.y_ = Urho3D::Max (1, Urho3D::CeilToInt (mapSize.y_ / cellSize_));
+
+    cells_.Clear ();
+    cells_.Resize (cellsCount_.x_ * cellsCount_.y_);
+}
+
+void UnitsSpatialGrid::Clear ()
+{
+    for (Urho3D::PODVector <Entry> &cell : cells_)
+    {
+        cell.Clear ();
+    }
+}
+
+void UnitsSpatialGrid::Insert (unsigned unitIndex, const Urho3D::Vector3 &position)
+{
+    cells_ [GetCellZ (position.z_) * cellsCount_.x_ + GetCellX (position.x_)].Push ({unitIndex, position});
+}
+
+void UnitsSpatialGrid::RemapUnits (const Urho3D::PODVector <unsigned> &newIndices)
+{
+    for (Urho3D::PODVector <Entry> &cell : cells_)
+    {
+        unsigned remainingCount = 0;
+        for (const Entry &entry : cell)
+        {
+            unsigned newIndex = entry.unitIndex_ < newIndices.Size () ?
+                    newIndices [entry.unitIndex_] : Urho3D::M_MAX_UNSIGNED;
+
+            if (newIndex != Urho3D::M_MAX_UNSIGNED)
+            {
+                cell [remainingCount] = {newIndex, entry.position_};
+                remainingCount++;
+            }
+        }
+        cell.Resize (remainingCount);
+    }
+}
+
+unsigned UnitsSpatialGrid::GetNearest (const Urho3D::Vector3 &position) const
+{
+    int centerX = GetCellX (position.x_);
+    int centerZ = GetCellZ (position.z_);
+    int maxRing = Urho3D::Max (Urho3D::Max (centerX, cellsCount_.x_ - 1 - centerX),
+            Urho3D::Max (centerZ, cellsCount_.y_ - 1 - centerZ));
+
+    float minimumDistance = INT_MAX;
+    unsigned nearest = Urho3D::M_MAX_UNSIGNED;
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // Units from this ring and further rings are at least (ring - 1) cells away.
+        if (nearest != Urho3D::M_MAX_UNSIGNED && minimumDistance < (ring - 1) * cellSize_)
+        {
+            break;
+        }
+
+        for (int z = Urho3D::Max (0, centerZ - ring); z <= Urho3D::Min (cellsCount_.y_ - 1, centerZ + ring); z++)
+        {
+            bool isBorderRow = ring == 0 || z == centerZ - ring || z == centerZ + ring;
+            int step = isBorderRow ? 1 : 2 * ring;
+
+            for (int x = centerX - ring; x <= centerX + ring; x += step)
+            {
+                if (x < 0 || x >= cellsCount_.x_)
+                {
+                    continue;
+                }
+
+                for (const Entry &entry : GetCell (x, z))
+                {
+                    float distance = (position - entry.position_).Length ();
+                    if (distance < minimumDistance || (distance == minimumDistance && entry.unitIndex_ < nearest))
+                    {
+                        minimumDistance = distance;
+                        nearest = entry.unitIndex_;
+                    }
+                }
+            }
+        }
+    }
+
+    return nearest;
+}
+
+bool UnitsSpatialGrid::HasUnitNear (const Urho3D::Vector3 &position, float radius) const
+{
+    Urho3D::Vector2 center = {position.x_, position.z_};
+    int minX = GetCellX (center.x_ - radius);
+    int maxX = GetCellX (center.x_ + radius);
+    int minZ = GetCellZ (center.y_ - radius);
+    int maxZ = GetCellZ (center.y_ + radius);
+
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            for (const Entry &entry : GetCell (x, z))
+            {
+                if ((Urho3D::Vector2 (entry.position_.x_, entry.position_.z_) - center).Length () <= radius)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void UnitsSpatialGrid::CollectUnitsNear (const Urho3D::Vector2 &position, float radius,
+        Urho3D::PODVector <unsigned> &output) const
+{
+    unsigned firstOutputIndex = output.Size ();
+    int minX = GetCellX (position.x_ - radius);
+    int maxX = GetCellX (position.x_ + radius);
+    int minZ = GetCellZ (position.y_ - radius);
+    int maxZ = GetCellZ (position.y_ + radius);
+
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            for (const Entry &entry : GetCell (x, z))
+            {
+                Urho3D::Vector2 unitPosition = {entry.position_.x_, entry.position_.z_};
+                if ((unitPosition - position).Length () <= radius)
+                {
+                    output.Push (entry.unitIndex_);
+                }
+            }
+        }
+    }
+
+    Urho3D::Sort (output.Begin () + firstOutputIndex, output.End ());
+}
+
+float UnitsSpatialGrid::GetCellSize () const
+{
+    return cellSize_;
+}
+
+const Urho3D::IntVector2 &UnitsSpatialGrid::GetCellsCount () const
+{
+    return cellsCount_;
+}
+
+int UnitsSpatialGrid::GetCellX (float x) const
+{
+    return Urho3D::Clamp (Urho3D::FloorToInt (x / cellSize_), 0, cellsCount_.x_ - 1);
+}
+
+int UnitsSpatialGrid::GetCellZ (float z) const
+{
+    return Urho3D::Clamp (Urho3D::FloorToInt (z / cellSize_), 0, cellsCount_.y_ - 1);
+}
+
+const Urho3D::PODVector <UnitsSpatialGrid::Entry> &UnitsSpatialGrid::GetCell (int x, int z) const
+{
+    return cells_ [z * cellsCount_.x_ + x];
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Vector2.h>
+#include <Urho3D/Math/Vector3.h>
+
+namespace CastlesStrategy
+{
+const float DEFAULT_UNITS_SPATIAL_GRID_CELL_SIZE = 10.0f;
+
+/// Uniform grid of dense unit indices over map XZ plane. Units outside of map bounds are clamped to border cells.
+/// UnitsManager keeps separate grid for each team, so queries do not filter units by team.
+class UnitsSpatialGrid
+{
+public:
+    UnitsSpatialGrid ();
+    virtual ~UnitsSpatialGrid ();
+
+    void Setup (const Urho3D::Vector2 &mapSize, float cellSize);
+    void Clear ();
+    void Insert (unsigned unitIndex, const Urho3D::Vector3 &position);
+    /// Replaces unit indices by new indices from given array, units with M_MAX_UNSIGNED new index are erased.
+    void RemapUnits (const Urho3D::PODVector <unsigned> &newIndices);
+
+    /// Returns index of nearest unit or M_MAX_UNSIGNED. Equal distances are resolved by lowest index.
+    unsigned GetNearest (const Urho3D::Vector3 &position) const;
+    /// Returns true if there is unit which XZ distance to position is less or equal to radius.
+    bool HasUnitNear (const Urho3D::Vector3 &position, float radius) const;
+    /// Appends indices, sorted ascending, of units which XZ distance to position is less or equal to radius.
+    void CollectUnitsNear (const Urho3D::Vector2 &position, float radius, Urho3D::PODVector <unsigned> &output) const;
+
+    float GetCellSize () const;
+    const Urho3D::IntVector2 &GetCellsCount () const;
+
+private:
+    struct Entry
+    {
+        unsigned unitIndex_;
+        Urho3D::Vector3 position_;
+    };
+
+    int GetCellX (float x) const;
+    int GetCellZ (float z) const;
+    const Urho3D::PODVector <Entry> &GetCell (int x, int z) const;
+
+    float cellSize_;
+    Urho3D::IntVector2 cellsCount_;
+    Urho3D::Vector <Urho3D::PODVector <Entry> > cells_;
+};
+}
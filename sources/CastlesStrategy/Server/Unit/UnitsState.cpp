@@ -0,0 +1,139 @@
+#include "UnitsState.hpp"
+#include <Urho3D/Scene/Node.h>
+
+namespace CastlesStrategy
+{
+UnitsState::UnitsState () :
+        units_ (),
+        handles_ (),
+        crowdAgents_ (),
+        positions_ (),
+
+        hp_ (),
+        attackCooldowns_ (),
+        belongsToFirst_ (),
+        unitTypes_ (),
+
+        routeIndices_ (),
+        currentWaypointIndices_ (),
+        currentWaypointTargets_ (),
+        lastCrowdCommandTypes_ (),
+        lastCrowdTargets_ (),
+        dirtyFlags_ ()
+{
+
+}
+
+UnitsState::~UnitsState ()
+{
+
+}
+
+unsigned UnitsState::Push (Unit *unit, Urho3D::CrowdAgent *crowdAgent, unsigned handle)
+{
+    units_.Push (unit);
+    handles_.Push (handle);
+    crowdAgents_.Push (crowdAgent);
+    positions_.Push (unit->GetNode ()->GetWorldPosition ());
+
+    hp_.Push (unit->GetHp ());
+    attackCooldowns_.Push (unit->GetAttackCooldown ());
+    belongsToFirst_.Push (unit->IsBelongsToFirst ());
+    unitTypes_.Push (unit->GetUnitType ());
+
+    routeIndices_.Push (unit->GetRouteIndex ());
+    currentWaypointIndices_.Push (unit->GetCurrentWaypointIndex ());
+    currentWaypointTargets_.Push (Urho3D::Vector3::ZERO);
+    lastCrowdCommandTypes_.Push (UCT_COMMANDS_COUNT);
+    lastCrowdTargets_.Push (Urho3D::Vector3::ZERO);
+    dirtyFlags_.Push (0);
+    return units_.Size () - 1;
+}
+
+void UnitsState::Move (unsigned from, unsigned to)
+{
+    units_ [to] = units_ [from];
+    handles_ [to] = handles_ [from];
+    crowdAgents_ [to] = crowdAgents_ [from];
+    positions_ [to] = positions_ [from];
+
+    hp_ [to] = hp_ [from];
+    attackCooldowns_ [to] = attackCooldowns_ [from];
+    belongsToFirst_ [to] = belongsToFirst_ [from];
+    unitTypes_ [to] = unitTypes_ [from];
+
+    routeIndices_ [to] = routeIndices_ [from];
+    currentWaypointIndices_ [to] = currentWaypointIndices_ [from];
+    currentWaypointTargets_ [to] = currentWaypointTargets_ [from];
+    lastCrowdCommandTypes_ [to] = lastCrowdCommandTypes_ [from];
+    lastCrowdTargets_ [to] = lastCrowdTargets_ [from];
+    dirtyFlags_ [to] = dirtyFlags_ [from];
+}
+
+void UnitsState::Resize (unsigned size)
+{
+    units_.Resize (size);
+    handles_.Resize (size);
+    crowdAgents_.Resize (size);
+    positions_.Resize (size);
+
+    hp_.Resize (size);
+    attackCooldowns_.Resize (size);
+    belongsToFirst_.Resize (size);
+    unitTypes_.Resize (size);
+
+    routeIndices_.Resize (size);
+    currentWaypointIndices_.Resize (size);
+    currentWaypointTargets_.Resize (size);
+    lastCrowdCommandTypes_.Resize (size);
+    lastCrowdTargets_.Resize (size);
+    dirtyFlags_.Resize (size);
+}
+
+unsigned UnitsState::Size () const
+{
+    return units_.Size ();
+}
+
+void UnitsState::ReadPositions ()
+{
+    for (unsigned index = 0; index < units_.Size (); index++)
+    {
+        positions_ [index] = units_ [index]->GetNode ()->GetWorldPosition ();
+    }
+}
+
+void UnitsState::WriteBack (unsigned index)
+{
+    unsigned char dirtyFlags = dirtyFlags_ [index];
+    if (dirtyFlags == 0)
+    {
+        return;
+    }
+
+    Unit *unit = units_ [index];
+    if (dirtyFlags & USDF_HP)
+    {
+        unit->SetHp (hp_ [index]);
+    }
+
+    if (dirtyFlags & USDF_ATTACK_COOLDOWN)
+    {
+        unit->SetAttackCooldown (attackCooldowns_ [index]);
+    }
+
+    if (dirtyFlags & USDF_CURRENT_WAYPOINT_INDEX)
+    {
+        unit->SetCurrentWaypointIndex (currentWaypointIndices_ [index]);
+    }
+    dirtyFlags_ [index] = 0;
+}
+
+void UnitsState::WriteBackAll ()
+{
+    for (unsigned index = 0; index < units_.Size (); index++)
+    {
+        WriteBack (index);
+    }
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Vector3.h>
+#include <Urho3D/Navigation/CrowdAgent.h>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Unit/UnitType.hpp>
+
+namespace CastlesStrategy
+{
+enum UnitStateDirtyFlag
+{
+    USDF_HP = 1 << 0,
+    USDF_ATTACK_COOLDOWN = 1 << 1,
+    USDF_CURRENT_WAYPOINT_INDEX = 1 << 2
+};
+
+/// Packed per tick simulation data of units, indexed by dense unit index.
+/// Units are kept in the order of addition, which is not ID order, because units from pool keep their node IDs.
+/// Changes are written back to Unit components only for fields marked as dirty.
+struct UnitsState
+{
+    UnitsState ();
+    virtual ~UnitsState ();
+
+    unsigned Push (Unit *unit, Urho3D::CrowdAgent *crowdAgent, unsigned handle);
+    void Move (unsigned from, unsigned to);
+    void Resize (unsigned size);
+    unsigned Size () const;
+
+    void ReadPositions ();
+    void WriteBack (unsigned index);
+    void WriteBackAll ();
+
+    Urho3D::PODVector <Unit *> units_;
+    /// Generational handles of units in UnitsManager slot map, AI commands reference units by them.
+    Urho3D::PODVector <unsigned> handles_;
+    Urho3D::PODVector <Urho3D::CrowdAgent *> crowdAgents_;
+    Urho3D::PODVector <Urho3D::Vector3> positions_;
+
+    Urho3D::PODVector <unsigned> hp_;
+    Urho3D::PODVector <float> attackCooldowns_;
+    Urho3D::PODVector <bool> belongsToFirst_;
+    Urho3D::PODVector <unsigned> unitTypes_;
+
+    Urho3D::PODVector <unsigned> routeIndices_;
+    Urho3D::PODVector <unsigned> currentWaypointIndices_;
+    /// Current waypoint projected on navigation mesh, prepared by UnitsManager before AI evaluation.
+    Urho3D::PODVector <Urho3D::Vector3> currentWaypointTargets_;
+
+    /// Last command type sent to crowd agent, UCT_COMMANDS_COUNT if there was no command yet.
+    Urho3D::PODVector <UnitCommandType> lastCrowdCommandTypes_;
+    /// Last not projected target sent to crowd agent.
+    Urho3D::PODVector <Urho3D::Vector3> lastCrowdTargets_;
+    Urho3D::PODVector <unsigned char> dirtyFlags_;
+};
+}
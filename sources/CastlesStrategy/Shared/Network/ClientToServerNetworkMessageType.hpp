@@ -15,6 +15,8 @@ enum ClientToServerNetworkMessageType
     CTSNMT_REQUEST_TO_CHANGE_TYPE,
     // IsReady : bool.
     CTSNMT_SET_IS_READY_FOR_START,
+    // MapName : String, ResourcesCount : UInt, Name : String x ResourcesCount.
+    CTSNMT_REQUEST_MAP_FILES,
     CTSNMT_TYPES_COUNT
 };
 }
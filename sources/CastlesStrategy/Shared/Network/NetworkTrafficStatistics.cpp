@@ -0,0 +1,203 @@
+#include "NetworkTrafficStatistics.hpp"
+#include <Urho3D/IO/Log.h>
+
+namespace CastlesStrategy
+{
+NetworkTrafficStatistics::NetworkTrafficStatistics (const Urho3D::String &ownerName, float logInterval) :
+        ownerName_ (ownerName),
+        sent_ (),
+        received_ (),
+        connections_ (),
+        logInterval_ (logInterval),
+        untilLog_ (logInterval)
+{
+
+}
+
+NetworkTrafficStatistics::~NetworkTrafficStatistics ()
+{
+
+}
+
+void NetworkTrafficStatistics::RecordSent (Urho3D::Connection *connection, int messageType, unsigned bytes)
+{
+    AddToCounter (sent_, messageType, bytes);
+    ConnectionTraffic &traffic = GetOrCreateConnectionTraffic (connection);
+    AddToCounter (traffic.sent_, messageType, bytes);
+    AddToCounter (traffic.sentTotal_, bytes);
+}
+
+void NetworkTrafficStatistics::RecordReceived (Urho3D::Connection *connection, int messageType, unsigned bytes)
+{
+    AddToCounter (received_, messageType, bytes);
+    ConnectionTraffic &traffic = GetOrCreateConnectionTraffic (connection);
+    AddToCounter (traffic.received_, messageType, bytes);
+    AddToCounter (traffic.receivedTotal_, bytes);
+}
+
+void NetworkTrafficStatistics::SampleConnection (Urho3D::Connection *connection, float timeStep)
+{
+    if (connection != nullptr)
+    {
+        ConnectionTraffic &traffic = GetOrCreateConnectionTraffic (connection);
+        traffic.engineBytesOut_ += connection->GetBytesOutPerSec () * timeStep;
+        traffic.engineBytesIn_ += connection->GetBytesInPerSec () * timeStep;
+    }
+}
+
+void NetworkTrafficStatistics::RemoveConnection (Urho3D::Connection *connection)
+{
+    ConnectionsTrafficMap::Iterator iterator = connections_.Find (connection);
+    if (iterator != connections_.End ())
+    {
+        URHO3D_LOGINFO (ownerName_ + ": traffic of closed connection:");
+        LogConnectionSummary (iterator->second_);
+        connections_.Erase (iterator);
+    }
+}
+
+void NetworkTrafficStatistics::Update (float timeStep)
+{
+    if (logInterval_ <= 0.0f)
+    {
+        return;
+    }
+
+    untilLog_ -= timeStep;
+    if (untilLog_ <= 0.0f)
+    {
+        untilLog_ = logInterval_;
+        LogSummary ();
+    }
+}
+
+void NetworkTrafficStatistics::Clear ()
+{
+    sent_.Clear ();
+    received_.Clear ();
+    connections_.Clear ();
+    untilLog_ = logInterval_;
+}
+
+NetworkTrafficCounter NetworkTrafficStatistics::GetSent (int messageType) const
+{
+    Urho3D::HashMap <int, NetworkTrafficCounter>::ConstIterator iterator = sent_.Find (messageType);
+    return iterator != sent_.End () ? iterator->second_ : NetworkTrafficCounter {0, 0};
+}
+
+NetworkTrafficCounter NetworkTrafficStatistics::GetReceived (int messageType) const
+{
+    Urho3D::HashMap <int, NetworkTrafficCounter>::ConstIterator iterator = received_.Find (messageType);
+    return iterator != received_.End () ? iterator->second_ : NetworkTrafficCounter {0, 0};
+}
+
+const NetworkTrafficStatistics::ConnectionsTrafficMap &NetworkTrafficStatistics::GetConnectionsTraffic () const
+{
+    return connections_;
+}
+
+const NetworkTrafficStatistics::ConnectionTraffic *NetworkTrafficStatistics::GetConnectionTraffic (
+        Urho3D::Connection *connection) const
+{
+    ConnectionsTrafficMap::ConstIterator iterator = connections_.Find (connection);
+    return iterator != connections_.End () ? &iterator->second_ : nullptr;
+}
+
+double NetworkTrafficStatistics::GetReplicationBytesOut (Urho3D::Connection *connection) const
+{
+    const ConnectionTraffic *traffic = GetConnectionTraffic (connection);
+    return traffic != nullptr ?
+            Urho3D::Max (0.0, traffic->engineBytesOut_ - static_cast <double> (traffic->sentTotal_.bytes_)) : 0.0;
+}
+
+double NetworkTrafficStatistics::GetReplicationBytesIn (Urho3D::Connection *connection) const
+{
+    const ConnectionTraffic *traffic = GetConnectionTraffic (connection);
+    return traffic != nullptr ?
+            Urho3D::Max (0.0, traffic->engineBytesIn_ - static_cast <double> (traffic->receivedTotal_.bytes_)) : 0.0;
+}
+
+float NetworkTrafficStatistics::GetLogInterval () const
+{
+    return logInterval_;
+}
+
+void NetworkTrafficStatistics::SetLogInterval (float logInterval)
+{
+    logInterval_ = logInterval;
+    untilLog_ = logInterval;
+}
+
+void NetworkTrafficStatistics::LogSummary () const
+{
+    URHO3D_LOGINFO (ownerName_ + ": sent messages by type: " + CountersToString (sent_) + ".");
+    URHO3D_LOGINFO (ownerName_ + ": received messages by type: " + CountersToString (received_) + ".");
+
+    for (const ConnectionsTrafficMap::KeyValue &connectionTraffic : connections_)
+    {
+        LogConnectionSummary (connectionTraffic.second_);
+    }
+}
+
+NetworkTrafficStatistics::ConnectionTraffic &NetworkTrafficStatistics::GetOrCreateConnectionTraffic (
+        Urho3D::Connection *connection)
+{
+    ConnectionsTrafficMap::Iterator iterator = connections_.Find (connection);
+    if (iterator == connections_.End ())
+    {
+        ConnectionTraffic traffic;
+        traffic.name_ = connection != nullptr ? connection->ToString () : "Unknown connection";
+        traffic.sentTotal_ = {0, 0};
+        traffic.receivedTotal_ = {0, 0};
+        traffic.engineBytesOut_ = 0.0;
+        traffic.engineBytesIn_ = 0.0;
+        iterator = connections_.Insert (Urho3D::MakePair (connection, traffic));
+    }
+    return iterator->second_;
+}
+
+void NetworkTrafficStatistics::AddToCounter (NetworkTrafficCounter &counter, unsigned bytes)
+{
+    counter.messages_++;
+    counter.bytes_ += bytes;
+}
+
+void NetworkTrafficStatistics::AddToCounter (Urho3D::HashMap <int, NetworkTrafficCounter> &counters,
+        int messageType, unsigned bytes)
+{
+    Urho3D::HashMap <int, NetworkTrafficCounter>::Iterator iterator = counters.Find (messageType);
+    if (iterator == counters.End ())
+    {
+        iterator = counters.Insert (Urho3D::MakePair (messageType, NetworkTrafficCounter {0, 0}));
+    }
+    AddToCounter (iterator->second_, bytes);
+}
+
+Urho3D::String NetworkTrafficStatistics::CountersToString (const Urho3D::HashMap <int, NetworkTrafficCounter> &counters)
+{
+    Urho3D::String result;
+    for (const Urho3D::HashMap <int, NetworkTrafficCounter>::KeyValue &counter : counters)
+    {
+        if (!result.Empty ())
+        {
+            result += ", ";
+        }
+
+        result += Urho3D::String (counter.first_) + ": " + Urho3D::String (counter.second_.messages_) +
+                " messages, " + Urho3D::String (counter.second_.bytes_) + " bytes";
+    }
+    return result.Empty () ? "none" : result;
+}
+
+void NetworkTrafficStatistics::LogConnectionSummary (const ConnectionTraffic &traffic) const
+{
+    URHO3D_LOGINFO (ownerName_ + ": connection " + traffic.name_ +
+            ": sent " + Urho3D::String (traffic.sentTotal_.messages_) + " messages with " +
+            Urho3D::String (traffic.sentTotal_.bytes_) + " bytes (" + CountersToString (traffic.sent_) + "), " +
+            "received " + Urho3D::String (traffic.receivedTotal_.messages_) + " messages with " +
+            Urho3D::String (traffic.receivedTotal_.bytes_) + " bytes (" + CountersToString (traffic.received_) + "), " +
+            "replication and protocol bytes out " +
+            Urho3D::String (Urho3D::Max (0.0, traffic.engineBytesOut_ - traffic.sentTotal_.bytes_)) +
+            ", in " + Urho3D::String (Urho3D::Max (0.0, traffic.engineBytesIn_ - traffic.receivedTotal_.bytes_)) + ".");
+}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Network/Connection.h>
+
+namespace CastlesStrategy
+{
+const float DEFAULT_NETWORK_TRAFFIC_LOG_INTERVAL = 30.0f;
+
+struct NetworkTrafficCounter
+{
+    unsigned messages_;
+    unsigned long long bytes_;
+};
+
+/// Counts custom messages and their payload bytes by message type and by connection. Scene replication is not
+/// a custom message, so it is estimated from engine measured connection bandwidth minus custom messages bytes.
+class NetworkTrafficStatistics
+{
+public:
+    struct ConnectionTraffic
+    {
+        Urho3D::String name_;
+        Urho3D::HashMap <int, NetworkTrafficCounter> sent_;
+        Urho3D::HashMap <int, NetworkTrafficCounter> received_;
+        NetworkTrafficCounter sentTotal_;
+        NetworkTrafficCounter receivedTotal_;
+        /// All bytes, including replication and protocol overhead, integrated from connection bandwidth.
+        double engineBytesOut_;
+        double engineBytesIn_;
+    };
+
+    typedef Urho3D::HashMap <Urho3D::Connection *, ConnectionTraffic> ConnectionsTrafficMap;
+
+    explicit NetworkTrafficStatistics (const Urho3D::String &ownerName,
+            float logInterval = DEFAULT_NETWORK_TRAFFIC_LOG_INTERVAL);
+    virtual ~NetworkTrafficStatistics ();
+
+    void RecordSent (Urho3D::Connection *connection, int messageType, unsigned bytes);
+    void RecordReceived (Urho3D::Connection *connection, int messageType, unsigned bytes);
+    /// Must be called every frame for every tracked connection to estimate replication traffic.
+    void SampleConnection (Urho3D::Connection *connection, float timeStep);
+    /// Logs summary of removed connection.
+    void RemoveConnection (Urho3D::Connection *connection);
+    /// Logs summary once per log interval. Zero log interval disables logging.
+    void Update (float timeStep);
+    void Clear ();
+
+    NetworkTrafficCounter GetSent (int messageType) const;
+    NetworkTrafficCounter GetReceived (int messageType) const;
+    const ConnectionsTrafficMap &GetConnectionsTraffic () const;
+    /// Returns nullptr if there is no traffic through this connection yet.
+    const ConnectionTraffic *GetConnectionTraffic (Urho3D::Connection *connection) const;
+    double GetReplicationBytesOut (Urho3D::Connection *connection) const;
+    double GetReplicationBytesIn (Urho3D::Connection *connection) const;
+
+    float GetLogInterval () const;
+    void SetLogInterval (float logInterval);
+    void LogSummary () const;
+
+private:
+    ConnectionTraffic &GetOrCreateConnectionTraffic (Urho3D::Connection *connection);
+    static void AddToCounter (NetworkTrafficCounter &counter, unsigned bytes);
+    static void AddToCounter (Urho3D::HashMap <int, NetworkTrafficCounter> &counters, int messageType, unsigned bytes);
+    static Urho3D::String CountersToString (const Urho3D::HashMap <int, NetworkTrafficCounter> &counters);
+    void LogConnectionSummary (const ConnectionTraffic &traffic) const;
+
+    Urho3D::String ownerName_;
+    Urho3D::HashMap <int, NetworkTrafficCounter> sent_;
+    Urho3D::HashMap <int, NetworkTrafficCounter> received_;
+    ConnectionsTrafficMap connections_;
+    float logInterval_;
+    float untilLog_;
+};
+}
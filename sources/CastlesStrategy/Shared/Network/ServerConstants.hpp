@@ -5,6 +5,11 @@ namespace CastlesStrategy
 {
 const float DEFAULT_AUTO_DISCONNECT_TIME = 1.0f;
 const unsigned int DEFAULT_SERVER_PORT = 10001;
+const float DEFAULT_STATISTICS_EXPORT_INTERVAL = 10.0f;
+const unsigned int DEFAULT_SIMULATION_RATE = 30;
+const unsigned int DEFAULT_MAX_SIMULATION_CATCH_UP_TICKS = 4;
+const unsigned int DEFAULT_MAP_FILES_CHUNK_SIZE = 32 * 1024;
+const unsigned int DEFAULT_MAP_FILES_CHUNKS_PER_UPDATE = 4;
 
 namespace IdentityFields
 {
@@ -13,4 +18,5 @@ const Urho3D::StringHash NAME ("Name");
 
 const Urho3D::String DEFAULT_MAPS_FOLDER ("Maps");
 const Urho3D::String DEFAULT_UNITS_TYPES_PATH ("DefaultUnits/Types.xml");
+const Urho3D::String DEFAULT_STATISTICS_EXPORT_PATH ("ServerTickStatistics.json");
 }
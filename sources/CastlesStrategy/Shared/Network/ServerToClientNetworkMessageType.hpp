@@ -7,7 +7,8 @@ enum ServerToClientNetworkMessageType
     STCNMT_START = 100,
     // GameStatus : Int.
     STCNMT_GAME_STATUS = 100,
-    // ID : UInt (node id).
+    // Node IDs of units and villages spawned during one server update.
+    // Count : UInt, ID : UInt (node id) x Count.
     STCNMT_OBJECT_SPAWNED,
     // UnitType : UInt, NewValue : UInt.
     STCNMT_UNITS_PULL_SYNC,
@@ -23,8 +24,15 @@ enum ServerToClientNetworkMessageType
     STCNMT_PLAYER_READY_CHANGED,
     // PlayerName : String.
     STCNMT_PLAYER_LEFT,
-    // MapName : String, ResourcesCount : UInt, (Name : String, Bytes : PODVector <UByte>) x ResourcesCount.
+    // One chunk of requested files transfer, sent only in response to CTSNMT_REQUEST_MAP_FILES. Chunks are sent
+    // in order and never contain data of several files, empty file is sent as one empty chunk. Data is compressed
+    // by LZ4. Client checks received files with manifest checksums and finishes download when all files are received.
+    // MapName : String, TransferSize : UInt, TransferOffset : UInt, FileName : String, FileSize : UInt,
+    // FileOffset : UInt, Size : UInt, CompressedSize : UInt, CompressedBytes : UByte x CompressedSize.
     STCNMT_MAP_FILES,
+    // Checksum is SDBM hash of file content, the same as Urho3D::File::GetChecksum.
+    // MapName : String, ResourcesCount : UInt, (Name : String, Size : UInt, Checksum : UInt) x ResourcesCount.
+    STCNMT_MAP_MANIFEST,
     STCNMT_TYPES_COUNT
 };
 }
@@ -1,10 +1,6 @@
 #include "BasicUnitAI.hpp"
-#include <climits>
 #include <Urho3D/Scene/Node.h>
-#include <Urho3D/Scene/Scene.h>
-
 #include <Urho3D/IO/Log.h>
-#include <Urho3D/Navigation/NavigationMesh.h>
 
 #include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
 #include <CastlesStrategy/Server/Managers/Map.hpp>
@@ -12,44 +8,43 @@
 
 namespace CastlesStrategy
 {
-UnitCommand BasicUnitAI (Unit *self, const UnitType &unitType, const ManagersHub *managersHub)
+UnitCommand BasicUnitAI (unsigned selfIndex, const UnitType &unitType, const ManagersHub *managersHub)
 {
     const UnitsManager *unitsManager = dynamic_cast <const UnitsManager *> (managersHub->GetManager (MI_UNITS_MANAGER));
-    const Unit *nearestEnemy = unitsManager->GetNearestEnemy (self);
+    const UnitsState &unitsState = unitsManager->GetUnitsState ();
+    const Urho3D::Vector3 &position = unitsState.positions_ [selfIndex];
+    unsigned nearestEnemy = unitsManager->GetNearestEnemy (selfIndex);
 
-    float distance = nearestEnemy != nullptr ?
-                     (self->GetNode ()->GetWorldPosition () - nearestEnemy->GetNode ()->GetWorldPosition ()).Length () : 0.0f;
-    float anotherUnitTypeNavigationRadius = nearestEnemy != nullptr ?
-            unitsManager->GetUnitType (nearestEnemy->GetUnitType ()).GetNavigationRadius () : 0.0f;
+    float distance = nearestEnemy != Urho3D::M_MAX_UNSIGNED ?
+                     (position - unitsState.positions_ [nearestEnemy]).Length () : 0.0f;
+    float anotherUnitTypeNavigationRadius = nearestEnemy != Urho3D::M_MAX_UNSIGNED ?
+            unitsManager->GetUnitType (unitsState.unitTypes_ [nearestEnemy]).GetNavigationRadius () : 0.0f;
 
-    if (nearestEnemy != nullptr && distance <=
+    if (nearestEnemy != Urho3D::M_MAX_UNSIGNED && distance <=
             anotherUnitTypeNavigationRadius + unitType.GetAttackRange () + unitType.GetNavigationRadius ())
     {
-        return {UCT_ATTACK_UNIT, nearestEnemy->GetID ()};
+        return {UCT_ATTACK_UNIT, unitsState.handles_ [nearestEnemy]};
     }
-    else if (nearestEnemy != nullptr && distance <= unitType.GetVisionRange ())
+    else if (nearestEnemy != Urho3D::M_MAX_UNSIGNED && distance <= unitType.GetVisionRange ())
     {
-        return {UCT_FOLLOW_UNIT, nearestEnemy->GetID ()};
+        return {UCT_FOLLOW_UNIT, unitsState.handles_ [nearestEnemy]};
     }
     else
     {
         const Map *map = dynamic_cast <const Map *> (managersHub->GetManager (MI_MAP));
-        Urho3D::Vector2 nextWaypoint = map->GetWaypoint (
-                self->GetRouteIndex (), self->GetCurrentWaypointIndex (), self->IsBelongsToFirst ());
-
-        Urho3D::Vector3 target = self->GetScene ()->GetComponent <Urho3D::NavigationMesh> ()->FindNearestPoint (
-                {nextWaypoint.x_, 0.0f, nextWaypoint.y_}, Urho3D::Vector3 (1.0f, INT_MAX, 1.0f));
-
-        distance = (self->GetNode ()->GetWorldPosition () - target).Length ();
-        unsigned nextWaypointIndex = self->GetCurrentWaypointIndex () + 1;
+        unsigned routeIndex = unitsState.routeIndices_ [selfIndex];
+        unsigned currentWaypointIndex = unitsState.currentWaypointIndices_ [selfIndex];
+        distance = (position - unitsState.currentWaypointTargets_ [selfIndex]).Length ();
+        unsigned nextWaypointIndex = currentWaypointIndex + 1;
 
+        // Waypoint index is passed as command argument, UnitsManager stores it while processing command.
         if (distance < unitType.GetAttackRange () &&
-                nextWaypointIndex < map->GetRoutes () [self->GetRouteIndex ()].GetWaypoints ().Size ())
+                nextWaypointIndex < map->GetRoutes () [routeIndex].GetWaypoints ().Size ())
         {
-            self->SetCurrentWaypointIndex (nextWaypointIndex);
+            return {UCT_MOVE_TO_WAYPOINT, nextWaypointIndex};
         }
 
-        return {UCT_MOVE_TO_WAYPOINT, 0};
+        return {UCT_MOVE_TO_WAYPOINT, currentWaypointIndex};
     }
 }
 }
@@ -2,5 +2,5 @@
 
 namespace CastlesStrategy
 {
-UnitCommand BasicUnitAI (Unit *self, const UnitType &unitType, const ManagersHub *managersHub);
+UnitCommand BasicUnitAI (unsigned selfIndex, const UnitType &unitType, const ManagersHub *managersHub);
 }
@@ -31,10 +31,11 @@ void Unit::RegisterObject (Urho3D::Context *context)
     URHO3D_ACCESSOR_ATTRIBUTE ("Is Belongs To First", IsBelongsToFirst, SetBelongsToFirst, bool, false, Urho3D::AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE ("HP", GetHp, SetHp, unsigned int, 0, Urho3D::AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE ("Unit Type", GetUnitType, SetUnitType, unsigned int, 0, Urho3D::AM_DEFAULT);
-    URHO3D_ACCESSOR_ATTRIBUTE ("Attack Cooldown", GetAttackCooldown, SetAttackCooldown, float, 0.0f, Urho3D::AM_DEFAULT);
+    // Cooldown and current waypoint are used only by server simulation, so they are saved, but not replicated.
+    URHO3D_ACCESSOR_ATTRIBUTE ("Attack Cooldown", GetAttackCooldown, SetAttackCooldown, float, 0.0f, Urho3D::AM_FILE);
 
     URHO3D_ACCESSOR_ATTRIBUTE ("Route Index", GetRouteIndex, SetRouteIndex, unsigned int, 0, Urho3D::AM_DEFAULT);
-    URHO3D_ACCESSOR_ATTRIBUTE ("Current Waypoint Index", GetCurrentWaypointIndex, SetCurrentWaypointIndex, unsigned int, 0, Urho3D::AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE ("Current Waypoint Index", GetCurrentWaypointIndex, SetCurrentWaypointIndex, unsigned int, 0, Urho3D::AM_FILE);
 }
 
 void Unit::UpdateCooldowns (float timeStep)
@@ -53,8 +54,11 @@ bool Unit::IsBelongsToFirst () const
 
 void Unit::SetBelongsToFirst (bool belongsToFirst)
 {
-    belongsToFirst_ = belongsToFirst;
-    MarkNetworkUpdate ();
+    if (belongsToFirst_ != belongsToFirst)
+    {
+        belongsToFirst_ = belongsToFirst;
+        MarkNetworkUpdate ();
+    }
 }
 
 unsigned int Unit::GetHp () const
@@ -64,8 +68,11 @@ unsigned int Unit::GetHp () const
 
 void Unit::SetHp (unsigned int hp)
 {
-    hp_ = hp;
-    MarkNetworkUpdate ();
+    if (hp_ != hp)
+    {
+        hp_ = hp;
+        MarkNetworkUpdate ();
+    }
 }
 
 unsigned int Unit::GetUnitType () const
@@ -75,8 +82,11 @@ unsigned int Unit::GetUnitType () const
 
 void Unit::SetUnitType (unsigned int unitType)
 {
-    unitType_ = unitType;
-    MarkNetworkUpdate ();
+    if (unitType_ != unitType)
+    {
+        unitType_ = unitType;
+        MarkNetworkUpdate ();
+    }
 }
 
 float Unit::GetAttackCooldown () const
@@ -92,7 +102,6 @@ void Unit::SetAttackCooldown (float attackCooldown)
     }
 
     attackCooldown_ = attackCooldown;
-    MarkNetworkUpdate ();
 }
 
 unsigned int Unit::GetCurrentWaypointIndex () const
@@ -103,7 +112,6 @@ unsigned int Unit::GetCurrentWaypointIndex () const
 void Unit::SetCurrentWaypointIndex (unsigned int currentWaypointIndex)
 {
     currentWaypointIndex_ = currentWaypointIndex;
-    MarkNetworkUpdate ();
 }
 
 unsigned int Unit::GetRouteIndex () const
@@ -113,8 +121,11 @@ unsigned int Unit::GetRouteIndex () const
 
 void Unit::SetRouteIndex (unsigned int routeIndex)
 {
-    routeIndex_ = routeIndex;
-    MarkNetworkUpdate ();
+    if (routeIndex_ != routeIndex)
+    {
+        routeIndex_ = routeIndex;
+        MarkNetworkUpdate ();
+    }
 }
 
 void Unit::OnSceneSet (Urho3D::Scene *scene)
@@ -20,6 +20,7 @@ enum UnitCommandType
 struct UnitCommand
 {
     UnitCommandType commandType_;
+    /// Waypoint index for move command, unit handle from UnitsManager for follow and attack commands.
     unsigned argument_;
 
     UnitCommand (UnitCommandType commandType, unsigned int argument);
@@ -29,7 +30,8 @@ struct UnitCommand
     bool operator != (const UnitCommand &rhs) const;
 };
 
-typedef UnitCommand (*UnitAIProcessor) (Unit *self, const UnitType &unitType, const ManagersHub *managersHub);
+/// AI receives dense unit index in UnitsManager units state and must not modify the state.
+typedef UnitCommand (*UnitAIProcessor) (unsigned selfIndex, const UnitType &unitType, const ManagersHub *managersHub);
 class UnitType
 {
 public:
@@ -9,7 +9,10 @@ Village::Village (Urho3D::Context *context) : Urho3D::Component (context),
     radius_ (0.1f),
     ownership_ (0.0f),
     wealthLevel_ (1.0f),
-    prefabPath_ ()
+    prefabPath_ (),
+
+    replicatedOwnership_ (0.0f),
+    timeUntilOwnershipReplication_ (0.0f)
 {
 
 }
@@ -43,7 +46,11 @@ void Village::UpdateOwnership (float timeStep, const UnitsManager *unitsManager)
     }
 
     FixOwnership ();
-    MarkNetworkUpdate ();
+    timeUntilOwnershipReplication_ -= timeStep;
+    if (IsOwnershipChangeReplicable ())
+    {
+        MarkOwnershipReplicated ();
+    }
 }
 
 unsigned int Village::TakeCoins (float timeStep) const
@@ -63,8 +70,11 @@ void Village::SetRadius (float radius)
         throw UniversalException <Village> ("Village: radius can not be zero or negative!");
     }
 
-    radius_ = radius;
-    MarkNetworkUpdate ();
+    if (radius_ != radius)
+    {
+        radius_ = radius;
+        MarkNetworkUpdate ();
+    }
 }
 
 float Village::GetOwnership () const
@@ -76,7 +86,7 @@ void Village::SetOwnership (float ownership)
 {
     ownership_ = ownership;
     FixOwnership ();
-    MarkNetworkUpdate ();
+    MarkOwnershipReplicated ();
 }
 
 float Village::GetWealthLevel () const
@@ -91,8 +101,11 @@ void Village::SetWealthLevel (float wealthLevel)
         throw UniversalException <Village> ("Village: wealth level can not be zero or negative!");
     }
 
-    wealthLevel_ = wealthLevel;
-    MarkNetworkUpdate ();
+    if (wealthLevel_ != wealthLevel)
+    {
+        wealthLevel_ = wealthLevel;
+        MarkNetworkUpdate ();
+    }
 }
 
 const Urho3D::String &Village::GetPrefabPath () const
@@ -102,8 +115,11 @@ const Urho3D::String &Village::GetPrefabPath () const
 
 void Village::SetPrefabPath (const Urho3D::String &prefabPath)
 {
-    prefabPath_ = prefabPath;
-    MarkNetworkUpdate ();
+    if (prefabPath_ != prefabPath)
+    {
+        prefabPath_ = prefabPath;
+        MarkNetworkUpdate ();
+    }
 }
 
 void Village::FixOwnership ()
@@ -117,4 +133,27 @@ void Village::FixOwnership ()
         ownership_ = -MAX_OWNERSHIP_POINTS;
     }
 }
+
+bool Village::IsOwnershipChangeReplicable () const
+{
+    if (ownership_ == replicatedOwnership_)
+    {
+        return false;
+    }
+
+    if ((ownership_ > 0.0f) != (replicatedOwnership_ > 0.0f) || Urho3D::Abs (ownership_) == MAX_OWNERSHIP_POINTS)
+    {
+        return true;
+    }
+
+    return timeUntilOwnershipReplication_ <= 0.0f &&
+            Urho3D::Abs (ownership_ - replicatedOwnership_) >= OWNERSHIP_REPLICATION_MIN_DELTA;
+}
+
+void Village::MarkOwnershipReplicated ()
+{
+    replicatedOwnership_ = ownership_;
+    timeUntilOwnershipReplication_ = OWNERSHIP_REPLICATION_MIN_INTERVAL;
+    MarkNetworkUpdate ();
+}
 }
@@ -6,6 +6,10 @@ namespace CastlesStrategy
 {
 const float MAX_OWNERSHIP_POINTS = 1000.0f;
 const float OWNERSHIP_TO_MONEY_PER_SECOND = 0.1f;
+/// Ownership changes during capture are replicated only if they are bigger than delta and not more often than
+/// once per interval. Owner change and reaching ownership limit are replicated immediately.
+const float OWNERSHIP_REPLICATION_MIN_DELTA = 1.0f;
+const float OWNERSHIP_REPLICATION_MIN_INTERVAL = 0.2f;
 
 class Village : public Urho3D::Component
 {
@@ -32,10 +36,15 @@ public:
 
 private:
     void FixOwnership ();
-    
+    bool IsOwnershipChangeReplicable () const;
+    void MarkOwnershipReplicated ();
+
     float radius_;
     float ownership_;
     float wealthLevel_;
     Urho3D::String prefabPath_;
+
+    float replicatedOwnership_;
+    float timeUntilOwnershipReplication_;
 };
 }
@@ -0,0 +1,318 @@
+#include "BotClient.hpp"
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include <CastlesStrategy/Shared/Network/ClientToServerNetworkMessageType.hpp>
+#include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
+#include <CastlesStrategy/Shared/Network/ServerToClientNetworkMessageType.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <Utils/UniversalException.hpp>
+
+BotClient::BotClient (Urho3D::Context *context, const Urho3D::String &name, const BotScript *script,
+        bool requestToBePlayer) : Urho3D::Object (context),
+    name_ (name),
+    script_ (script),
+    requestToBePlayer_ (requestToBePlayer),
+    scene_ (new Urho3D::Scene (context)),
+
+    connected_ (false),
+    typeRequested_ (false),
+    readySent_ (false),
+    timeSinceConnection_ (0.0f),
+    playerType_ (CastlesStrategy::PT_OBSERVER),
+    gameStatus_ (CastlesStrategy::GS_WAITING),
+
+    coins_ (0),
+    spawnsUnitType_ (0),
+    unitsPull_ (),
+    recruitmentCosts_ (),
+
+    scriptTime_ (0.0f),
+    nextActionIndex_ (0),
+    executedActionsCount_ (0),
+    skippedActionsCount_ (0)
+{
+    SubscribeToEvent (Urho3D::E_SERVERCONNECTED, URHO3D_HANDLER (BotClient, HandleServerConnected));
+    SubscribeToEvent (Urho3D::E_SERVERDISCONNECTED, URHO3D_HANDLER (BotClient, HandleServerDisconnected));
+    SubscribeToEvent (Urho3D::E_CONNECTFAILED, URHO3D_HANDLER (BotClient, HandleServerDisconnected));
+    SubscribeToEvent (Urho3D::E_NETWORKMESSAGE, URHO3D_HANDLER (BotClient, HandleNetworkMessage));
+}
+
+BotClient::~BotClient ()
+{
+    UnsubscribeFromAllEvents ();
+}
+
+void BotClient::Connect (const Urho3D::String &address, unsigned int port)
+{
+    Urho3D::VariantMap identity;
+    identity [CastlesStrategy::IdentityFields::NAME] = name_;
+    context_->GetSubsystem <Urho3D::Network> ()->Connect (address, port, scene_, identity);
+}
+
+void BotClient::Disconnect ()
+{
+    context_->GetSubsystem <Urho3D::Network> ()->Disconnect ();
+    connected_ = false;
+}
+
+void BotClient::Update (float timeStep)
+{
+    Urho3D::Network *network = context_->GetSubsystem <Urho3D::Network> ();
+    network->Update (timeStep);
+
+    // Scene is updated only to finish loading, replicated scene content is not simulated by bots.
+    if (scene_->IsAsyncLoading ())
+    {
+        scene_->Update (timeStep);
+    }
+
+    if (connected_)
+    {
+        if (gameStatus_ == CastlesStrategy::GS_WAITING)
+        {
+            UpdateLobby (timeStep);
+        }
+        else if (gameStatus_ == CastlesStrategy::GS_PLAYING &&
+                (playerType_ == CastlesStrategy::PT_FIRST || playerType_ == CastlesStrategy::PT_SECOND))
+        {
+            UpdateScript (timeStep);
+        }
+    }
+    network->PostUpdate (timeStep);
+}
+
+const Urho3D::String &BotClient::GetName () const
+{
+    return name_;
+}
+
+CastlesStrategy::PlayerType BotClient::GetPlayerType () const
+{
+    return playerType_;
+}
+
+CastlesStrategy::GameStatus BotClient::GetGameStatus () const
+{
+    return gameStatus_;
+}
+
+bool BotClient::IsConnected () const
+{
+    return connected_;
+}
+
+unsigned int BotClient::GetExecutedActionsCount () const
+{
+    return executedActionsCount_;
+}
+
+unsigned int BotClient::GetSkippedActionsCount () const
+{
+    return skippedActionsCount_;
+}
+
+void BotClient::HandleServerConnected (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    connected_ = true;
+    timeSinceConnection_ = 0.0f;
+}
+
+void BotClient::HandleServerDisconnected (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    if (connected_)
+    {
+        URHO3D_LOGINFO ("BotClient: " + name_ + " is disconnected, executed " + Urho3D::String (executedActionsCount_) +
+                " actions and skipped " + Urho3D::String (skippedActionsCount_) + ".");
+    }
+    else
+    {
+        URHO3D_LOGWARNING ("BotClient: " + name_ + " can not connect to server!");
+    }
+    connected_ = false;
+}
+
+void BotClient::HandleNetworkMessage (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    int messageId = eventData [Urho3D::NetworkMessage::P_MESSAGEID].GetInt ();
+    Urho3D::VectorBuffer messageData = eventData [Urho3D::NetworkMessage::P_DATA].GetVectorBuffer ();
+
+    if (messageId == CastlesStrategy::STCNMT_GAME_STATUS)
+    {
+        gameStatus_ = static_cast <CastlesStrategy::GameStatus> (messageData.ReadUInt ());
+        scriptTime_ = 0.0f;
+        nextActionIndex_ = 0;
+    }
+    else if (messageId == CastlesStrategy::STCNMT_NEW_PLAYER ||
+            messageId == CastlesStrategy::STCNMT_PLAYER_TYPE_CHANGED)
+    {
+        ProcessPlayerTypeMessage (messageData);
+    }
+    else if (messageId == CastlesStrategy::STCNMT_UNITS_PULL_SYNC)
+    {
+        unsigned int unitType = messageData.ReadUInt ();
+        unsigned int newValue = messageData.ReadUInt ();
+        if (unitType >= unitsPull_.Size ())
+        {
+            unitsPull_.Resize (unitType + 1, 0);
+        }
+        unitsPull_ [unitType] = newValue;
+    }
+    else if (messageId == CastlesStrategy::STCNMT_COINS_SYNC)
+    {
+        coins_ = messageData.ReadUInt ();
+    }
+    else if (messageId == CastlesStrategy::STCNMT_MAP_MANIFEST)
+    {
+        // Bots are started near server and use the same data folder, so map files are never requested.
+        LoadUnitsTypes (messageData.ReadString ());
+    }
+}
+
+void BotClient::ProcessPlayerTypeMessage (Urho3D::VectorBuffer &messageData)
+{
+    Urho3D::String name = messageData.ReadString ();
+    if (name == name_)
+    {
+        playerType_ = static_cast <CastlesStrategy::PlayerType> (messageData.ReadUByte ());
+    }
+}
+
+void BotClient::LoadUnitsTypes (const Urho3D::String &mapName)
+{
+    Urho3D::ResourceCache *resourceCache = context_->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::String mapFolder = CastlesStrategy::DEFAULT_MAPS_FOLDER + "/" + mapName + "/";
+    Urho3D::XMLFile *mapXMLFile = resourceCache->GetResource <Urho3D::XMLFile> (mapFolder + "Map.xml");
+
+    if (mapXMLFile == nullptr)
+    {
+        throw UniversalException <BotClient> ("BotClient: can not find map " + mapName + " xml!");
+    }
+
+    Urho3D::String unitsTypesXMLPath = mapXMLFile->GetRoot ().GetBool ("useDefaultUnitsTypes") ?
+            CastlesStrategy::DEFAULT_UNITS_TYPES_PATH : mapFolder + "UnitsTypes.xml";
+    Urho3D::XMLFile *unitsTypesXMLFile = resourceCache->GetResource <Urho3D::XMLFile> (unitsTypesXMLPath);
+
+    if (unitsTypesXMLFile == nullptr)
+    {
+        throw UniversalException <BotClient> ("BotClient: can not find units types xml " + unitsTypesXMLPath + "!");
+    }
+
+    Urho3D::XMLElement unitsTypesXML = unitsTypesXMLFile->GetRoot ();
+    spawnsUnitType_ = unitsTypesXML.GetUInt ("spawnsUnitType");
+    recruitmentCosts_.Clear ();
+
+    for (Urho3D::XMLElement element = unitsTypesXML.GetChild ("unitType"); element.NotNull ();
+            element = element.GetNext ("unitType"))
+    {
+        recruitmentCosts_.Push (element.GetUInt ("recruitmentCost"));
+    }
+}
+
+void BotClient::UpdateLobby (float timeStep)
+{
+    timeSinceConnection_ += timeStep;
+    if (requestToBePlayer_ && !typeRequested_ && playerType_ == CastlesStrategy::PT_OBSERVER)
+    {
+        Urho3D::VectorBuffer messageData;
+        messageData.WriteUByte (CastlesStrategy::PT_REQUESTED_TO_BE_PLAYER);
+        SendMessageToServer (CastlesStrategy::CTSNMT_REQUEST_TO_CHANGE_TYPE, messageData);
+        typeRequested_ = true;
+    }
+
+    if (!readySent_ && timeSinceConnection_ >= script_->GetReadyDelay ())
+    {
+        Urho3D::VectorBuffer messageData;
+        messageData.WriteBool (true);
+        SendMessageToServer (CastlesStrategy::CTSNMT_SET_IS_READY_FOR_START, messageData);
+        readySent_ = true;
+    }
+}
+
+void BotClient::UpdateScript (float timeStep)
+{
+    const Urho3D::PODVector <BotAction> &actions = script_->GetActions ();
+    scriptTime_ += timeStep;
+
+    while (nextActionIndex_ < actions.Size () && actions [nextActionIndex_].time_ <= scriptTime_)
+    {
+        if (ExecuteAction (actions [nextActionIndex_]))
+        {
+            executedActionsCount_++;
+        }
+        else
+        {
+            skippedActionsCount_++;
+        }
+        nextActionIndex_++;
+    }
+
+    if (nextActionIndex_ >= actions.Size () && script_->GetRepeatInterval () > 0.0f &&
+            scriptTime_ >= script_->GetRepeatInterval ())
+    {
+        scriptTime_ -= script_->GetRepeatInterval ();
+        nextActionIndex_ = 0;
+    }
+}
+
+bool BotClient::ExecuteAction (const BotAction &action)
+{
+    // Server treats impossible orders as errors, so bot checks them with synchronized coins and units pull.
+    Urho3D::VectorBuffer messageData;
+    if (action.type_ == BAT_ADD_ORDER)
+    {
+        if (action.unitType_ >= recruitmentCosts_.Size () || coins_ < recruitmentCosts_ [action.unitType_])
+        {
+            return false;
+        }
+
+        coins_ -= recruitmentCosts_ [action.unitType_];
+        messageData.WriteUInt (action.unitType_);
+        SendMessageToServer (CastlesStrategy::CTSNMT_ADD_ORDER, messageData);
+        return true;
+    }
+    else
+    {
+        unsigned int spawnId = FindSpawnId (action.route_);
+        if (action.unitType_ >= unitsPull_.Size () || unitsPull_ [action.unitType_] == 0 ||
+                spawnId == Urho3D::M_MAX_UNSIGNED)
+        {
+            return false;
+        }
+
+        unitsPull_ [action.unitType_]--;
+        messageData.WriteUInt (spawnId);
+        messageData.WriteUInt (action.unitType_);
+        SendMessageToServer (CastlesStrategy::CTSNMT_SPAWN_UNIT, messageData);
+        return true;
+    }
+}
+
+unsigned int BotClient::FindSpawnId (unsigned int route) const
+{
+    Urho3D::PODVector <CastlesStrategy::Unit *> units;
+    scene_->GetComponents <CastlesStrategy::Unit> (units, true);
+    bool belongsToFirst = playerType_ == CastlesStrategy::PT_FIRST;
+
+    for (CastlesStrategy::Unit *unit : units)
+    {
+        if (unit->GetUnitType () == spawnsUnitType_ && unit->IsBelongsToFirst () == belongsToFirst &&
+                unit->GetRouteIndex () == route && unit->GetHp () > 0)
+        {
+            return unit->GetID ();
+        }
+    }
+    return Urho3D::M_MAX_UNSIGNED;
+}
+
+void BotClient::SendMessageToServer (int messageType, const Urho3D::VectorBuffer &messageData)
+{
+    Urho3D::Connection *serverConnection = context_->GetSubsystem <Urho3D::Network> ()->GetServerConnection ();
+    if (serverConnection != nullptr)
+    {
+        serverConnection->SendMessage (messageType, true, true, messageData);
+    }
+}
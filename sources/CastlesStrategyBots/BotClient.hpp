@@ -0,0 +1,66 @@
+#pragma once
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <CastlesStrategy/Shared/Network/GameStatus.hpp>
+#include <CastlesStrategy/Shared/PlayerType.hpp>
+#include "BotScript.hpp"
+
+/// Headless client, which connects to server, identifies, requests to be player or stays observer, marks itself
+/// ready and then executes script with the same messages as real client. Must be created in its own context with
+/// its own Network subsystem, because Network supports only one server connection.
+class BotClient : public Urho3D::Object
+{
+URHO3D_OBJECT (BotClient, Object)
+public:
+    BotClient (Urho3D::Context *context, const Urho3D::String &name, const BotScript *script, bool requestToBePlayer);
+    virtual ~BotClient ();
+
+    void Connect (const Urho3D::String &address, unsigned int port);
+    void Disconnect ();
+    /// Network subsystem of bot context does not receive engine frame events, so bot updates it manually.
+    void Update (float timeStep);
+
+    const Urho3D::String &GetName () const;
+    CastlesStrategy::PlayerType GetPlayerType () const;
+    CastlesStrategy::GameStatus GetGameStatus () const;
+    bool IsConnected () const;
+    unsigned int GetExecutedActionsCount () const;
+    unsigned int GetSkippedActionsCount () const;
+
+private:
+    void HandleServerConnected (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+    void HandleServerDisconnected (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+    void HandleNetworkMessage (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+
+    void ProcessPlayerTypeMessage (Urho3D::VectorBuffer &messageData);
+    void LoadUnitsTypes (const Urho3D::String &mapName);
+    void UpdateLobby (float timeStep);
+    void UpdateScript (float timeStep);
+    bool ExecuteAction (const BotAction &action);
+    unsigned int FindSpawnId (unsigned int route) const;
+    void SendMessageToServer (int messageType, const Urho3D::VectorBuffer &messageData);
+
+    Urho3D::String name_;
+    const BotScript *script_;
+    bool requestToBePlayer_;
+    Urho3D::SharedPtr <Urho3D::Scene> scene_;
+
+    bool connected_;
+    bool typeRequested_;
+    bool readySent_;
+    float timeSinceConnection_;
+    CastlesStrategy::PlayerType playerType_;
+    CastlesStrategy::GameStatus gameStatus_;
+
+    unsigned int coins_;
+    unsigned int spawnsUnitType_;
+    Urho3D::PODVector <unsigned int> unitsPull_;
+    Urho3D::PODVector <unsigned int> recruitmentCosts_;
+
+    float scriptTime_;
+    unsigned int nextActionIndex_;
+    unsigned int executedActionsCount_;
+    unsigned int skippedActionsCount_;
+};
@@ -0,0 +1,66 @@
+#include "BotScript.hpp"
+#include <Urho3D/Container/Sort.h>
+#include <Utils/UniversalException.hpp>
+
+BotScript::BotScript () :
+        readyDelay_ (0.0f),
+        repeatInterval_ (0.0f),
+        actions_ ()
+{
+
+}
+
+BotScript::~BotScript ()
+{
+
+}
+
+void BotScript::LoadFromXML (const Urho3D::XMLElement &input)
+{
+    readyDelay_ = input.GetFloat ("readyDelay");
+    repeatInterval_ = input.GetFloat ("repeatInterval");
+    actions_.Clear ();
+
+    for (Urho3D::XMLElement element = input.GetChild (); element.NotNull (); element = element.GetNext ())
+    {
+        BotAction action;
+        action.time_ = element.GetFloat ("time");
+        action.unitType_ = element.GetUInt ("unitType");
+        action.route_ = element.GetUInt ("route");
+
+        if (element.GetName () == "addOrder")
+        {
+            action.type_ = BAT_ADD_ORDER;
+        }
+        else if (element.GetName () == "spawnUnit")
+        {
+            action.type_ = BAT_SPAWN_UNIT;
+        }
+        else
+        {
+            throw UniversalException <BotScript> ("BotScript: unknown action " + element.GetName () + "!");
+        }
+        actions_.Push (action);
+    }
+
+    Urho3D::Sort (actions_.Begin (), actions_.End (),
+            [] (const BotAction &first, const BotAction &second) -> bool
+            {
+                return first.time_ < second.time_;
+            });
+}
+
+float BotScript::GetReadyDelay () const
+{
+    return readyDelay_;
+}
+
+float BotScript::GetRepeatInterval () const
+{
+    return repeatInterval_;
+}
+
+const Urho3D::PODVector <BotAction> &BotScript::GetActions () const
+{
+    return actions_;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Resource/XMLElement.h>
+
+enum BotActionType
+{
+    BAT_ADD_ORDER = 0,
+    BAT_SPAWN_UNIT
+};
+
+struct BotAction
+{
+    /// Seconds since game start or since script repeat.
+    float time_;
+    BotActionType type_;
+    unsigned int unitType_;
+    /// Used only by spawn unit action, spawn of bot side on this route is used.
+    unsigned int route_;
+};
+
+/// Sequence of recruit and spawn actions, which every player bot executes after game start.
+class BotScript
+{
+public:
+    BotScript ();
+    virtual ~BotScript ();
+
+    void LoadFromXML (const Urho3D::XMLElement &input);
+
+    float GetReadyDelay () const;
+    /// If zero, script is executed only once.
+    float GetRepeatInterval () const;
+    /// Actions, sorted by time.
+    const Urho3D::PODVector <BotAction> &GetActions () const;
+
+private:
+    float readyDelay_;
+    float repeatInterval_;
+    Urho3D::PODVector <BotAction> actions_;
+};
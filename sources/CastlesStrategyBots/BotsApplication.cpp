@@ -0,0 +1,232 @@
+#include "BotsApplication.hpp"
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Network/Network.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Village/Village.hpp>
+#include <Utils/UniversalException.hpp>
+
+URHO3D_DEFINE_APPLICATION_MAIN (BotsApplication)
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+BotsApplication::BotsApplication (Urho3D::Context *context) : Urho3D::Application (context),
+    serverAddress_ (DEFAULT_BOTS_SERVER_ADDRESS),
+    serverPort_ (CastlesStrategy::DEFAULT_SERVER_PORT),
+    botsCount_ (DEFAULT_BOTS_COUNT),
+    playersCount_ (DEFAULT_BOTS_PLAYERS_COUNT),
+    scriptPath_ (DEFAULT_BOTS_SCRIPT_PATH),
+    duration_ (0.0f),
+
+    script_ (),
+    botsContexts_ (),
+    bots_ (),
+    elapsedTime_ (0.0f)
+{
+
+}
+
+BotsApplication::~BotsApplication ()
+{
+
+}
+
+void BotsApplication::Setup ()
+{
+    Urho3D::String time = Urho3D::Time::GetTimeStamp ();
+    time.Replace (':', ' ');
+    std::set_terminate (CustomTerminate);
+
+    engineParameters_ [Urho3D::EP_HEADLESS] = true;
+    engineParameters_ [Urho3D::EP_SOUND] = false;
+    engineParameters_ [Urho3D::EP_LOG_NAME] = "CastlesStrategyBots " + time + ".log";
+
+    if (!ParseBotsArguments ())
+    {
+        ErrorExit ("Usage: CastlesStrategyBots [--address <server address>] [--port <port>] [--bots <count>] "
+                "[--players <count>] [--script <bot script path>] [--duration <seconds>]");
+    }
+}
+
+void BotsApplication::Start ()
+{
+    Urho3D::XMLFile *scriptXMLFile = GetSubsystem <Urho3D::ResourceCache> ()->GetResource <Urho3D::XMLFile> (scriptPath_);
+    if (scriptXMLFile == nullptr)
+    {
+        ErrorExit ("CastlesStrategyBots: can not find bot script " + scriptPath_ + "!");
+        return;
+    }
+    script_.LoadFromXML (scriptXMLFile->GetRoot ());
+
+    for (unsigned int index = 0; index < botsCount_; index++)
+    {
+        Urho3D::Context *botContext = CreateBotContext ();
+        botsContexts_.Push (Urho3D::SharedPtr <Urho3D::Context> (botContext));
+
+        BotClient *bot = new BotClient (botContext, "Bot" + Urho3D::String (index), &script_, index < playersCount_);
+        bots_.Push (Urho3D::SharedPtr <BotClient> (bot));
+        bot->Connect (serverAddress_, serverPort_);
+    }
+
+    SubscribeToEvent (Urho3D::E_UPDATE, URHO3D_HANDLER (BotsApplication, HandleUpdate));
+    URHO3D_LOGINFO ("CastlesStrategyBots: connecting " + Urho3D::String (botsCount_) + " bots (" +
+            Urho3D::String (Urho3D::Min (playersCount_, botsCount_)) + " players) to " + serverAddress_ + ":" +
+            Urho3D::String (serverPort_) + ".");
+}
+
+void BotsApplication::Stop ()
+{
+    LogSummary ();
+    for (Urho3D::SharedPtr <BotClient> &bot : bots_)
+    {
+        bot->Disconnect ();
+    }
+
+    bots_.Clear ();
+    botsContexts_.Clear ();
+}
+
+bool BotsApplication::ParseBotsArguments ()
+{
+    // Engine parses its own arguments too, so only long options are used here: "-p" is engine resource paths option.
+    const Urho3D::Vector <Urho3D::String> &arguments = Urho3D::GetArguments ();
+    for (unsigned index = 0; index < arguments.Size (); index++)
+    {
+        const Urho3D::String &argument = arguments [index];
+        if (!argument.StartsWith ("--"))
+        {
+            continue;
+        }
+
+        if (index + 1 >= arguments.Size ())
+        {
+            return false;
+        }
+
+        const Urho3D::String &value = arguments [++index];
+        if (argument == "--address")
+        {
+            serverAddress_ = value;
+        }
+        else if (argument == "--port")
+        {
+            serverPort_ = Urho3D::ToUInt (value);
+            if (serverPort_ == 0 || serverPort_ > Urho3D::M_MAX_UNSIGNED_SHORT)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--bots")
+        {
+            botsCount_ = Urho3D::ToUInt (value);
+            if (botsCount_ == 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--players")
+        {
+            playersCount_ = Urho3D::ToUInt (value);
+        }
+        else if (argument == "--script")
+        {
+            scriptPath_ = value;
+        }
+        else if (argument == "--duration")
+        {
+            duration_ = Urho3D::ToFloat (value);
+            if (duration_ <= 0.0f)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Urho3D::Context *BotsApplication::CreateBotContext ()
+{
+    Urho3D::Context *botContext = new Urho3D::Context ();
+    botContext->RegisterSubsystem (GetSubsystem <Urho3D::Time> ());
+    botContext->RegisterSubsystem (GetSubsystem <Urho3D::WorkQueue> ());
+    botContext->RegisterSubsystem (GetSubsystem <Urho3D::FileSystem> ());
+    botContext->RegisterSubsystem (GetSubsystem <Urho3D::Log> ());
+    botContext->RegisterSubsystem (GetSubsystem <Urho3D::ResourceCache> ());
+    botContext->RegisterSubsystem (new Urho3D::Network (botContext));
+
+    // Replicated scene contains graphics and navigation components, so their factories are needed too.
+    Urho3D::RegisterSceneLibrary (botContext);
+    Urho3D::RegisterGraphicsLibrary (botContext);
+    Urho3D::RegisterNavigationLibrary (botContext);
+    CastlesStrategy::Unit::RegisterObject (botContext);
+    CastlesStrategy::Village::RegisterObject (botContext);
+    return botContext;
+}
+
+void BotsApplication::HandleUpdate (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    float timeStep = eventData [Urho3D::Update::P_TIMESTEP].GetFloat ();
+    for (Urho3D::SharedPtr <BotClient> &bot : bots_)
+    {
+        bot->Update (timeStep);
+    }
+
+    elapsedTime_ += timeStep;
+    if (duration_ > 0.0f && elapsedTime_ >= duration_)
+    {
+        GetSubsystem <Urho3D::Engine> ()->Exit ();
+    }
+}
+
+void BotsApplication::LogSummary () const
+{
+    unsigned int connectedCount = 0;
+    unsigned int executedActionsCount = 0;
+    unsigned int skippedActionsCount = 0;
+
+    for (const Urho3D::SharedPtr <BotClient> &bot : bots_)
+    {
+        if (bot->IsConnected ())
+        {
+            connectedCount++;
+        }
+
+        executedActionsCount += bot->GetExecutedActionsCount ();
+        skippedActionsCount += bot->GetSkippedActionsCount ();
+    }
+
+    URHO3D_LOGINFO ("CastlesStrategyBots: " + Urho3D::String (connectedCount) + " of " + Urho3D::String (bots_.Size ()) +
+            " bots are connected after " + Urho3D::String (elapsedTime_) + " seconds, " +
+            Urho3D::String (executedActionsCount) + " actions executed and " +
+            Urho3D::String (skippedActionsCount) + " actions skipped.");
+}
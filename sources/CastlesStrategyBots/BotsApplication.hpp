@@ -0,0 +1,46 @@
+#pragma once
+#include <Urho3D/Engine/Application.h>
+#include "BotClient.hpp"
+#include "BotScript.hpp"
+
+const Urho3D::String DEFAULT_BOTS_SERVER_ADDRESS ("localhost");
+const unsigned int DEFAULT_BOTS_COUNT = 10;
+const unsigned int DEFAULT_BOTS_PLAYERS_COUNT = 2;
+const Urho3D::String DEFAULT_BOTS_SCRIPT_PATH ("Bots/DefaultScript.xml");
+
+/// Headless application, which connects many bots to server for load testing. First bots request to be players
+/// and execute script, other bots stay observers and only receive replication. Usage:
+/// CastlesStrategyBots [--address <server address>] [--port <port>] [--bots <count>] [--players <count>]
+///     [--script <bot script path>] [--duration <seconds>]
+/// If duration is not specified, bots work until application is closed.
+class BotsApplication : public Urho3D::Application
+{
+URHO3D_OBJECT (BotsApplication, Application)
+public:
+    explicit BotsApplication (Urho3D::Context *context);
+    virtual ~BotsApplication ();
+
+    virtual void Setup ();
+    virtual void Start ();
+    virtual void Stop ();
+
+private:
+    bool ParseBotsArguments ();
+    /// Network subsystem supports only one server connection, so every bot has its own context, which shares
+    /// all other subsystems with application context.
+    Urho3D::Context *CreateBotContext ();
+    void HandleUpdate (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+    void LogSummary () const;
+
+    Urho3D::String serverAddress_;
+    unsigned int serverPort_;
+    unsigned int botsCount_;
+    unsigned int playersCount_;
+    Urho3D::String scriptPath_;
+    float duration_;
+
+    BotScript script_;
+    Urho3D::Vector <Urho3D::SharedPtr <Urho3D::Context> > botsContexts_;
+    Urho3D::Vector <Urho3D::SharedPtr <BotClient> > bots_;
+    float elapsedTime_;
+};
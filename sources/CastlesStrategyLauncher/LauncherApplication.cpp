@@ -11,6 +11,7 @@
 
 #include <CastlesStrategy/Client/MainMenu/MainMenuActivity.hpp>
 #include <CastlesStrategy/Client/Ingame/IngameActivity.hpp>
+#include <CastlesStrategy/Client/Ingame/UnitMotionInterpolator.hpp>
 #include <CastlesStrategy/Server/Activity/ServerActivity.hpp>
 #include <CastlesStrategy/Shared/ActivitiesControlEvents.hpp>
 #include <CastlesStrategy/Shared/Village/Village.hpp>
@@ -60,6 +61,7 @@ void LauncherApplication::Start ()
     UIResizer::RegisterObject (context_);
     CastlesStrategy::Unit::RegisterObject (context_);
     CastlesStrategy::Village::RegisterObject (context_);
+    CastlesStrategy::UnitMotionInterpolator::RegisterObject (context_);
     
     Urho3D::Script *script = new Urho3D::Script (context_);
     context_->RegisterSubsystem (script);
@@ -0,0 +1,198 @@
+#include "ServerApplication.hpp"
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Network.h>
+
+#include <CastlesStrategy/Server/Activity/ServerActivity.hpp>
+#include <CastlesStrategy/Shared/ActivitiesControlEvents.hpp>
+#include <CastlesStrategy/Shared/Network/ServerConstants.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Village/Village.hpp>
+#include <Utils/UniversalException.hpp>
+
+URHO3D_DEFINE_APPLICATION_MAIN (ServerApplication)
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+ServerApplication::ServerApplication (Urho3D::Context *context) : ActivitiesApplication::ActivitiesApplication (context),
+    mapName_ (DEFAULT_SERVER_MAP_NAME),
+    serverPort_ (CastlesStrategy::DEFAULT_SERVER_PORT),
+    tickRate_ (DEFAULT_SERVER_TICK_RATE),
+    networkUpdateFps_ (DEFAULT_SERVER_NETWORK_UPDATE_FPS),
+    workerThreads_ (-1),
+    recordPath_ (),
+    replayPath_ ()
+{
+
+}
+
+ServerApplication::~ServerApplication ()
+{
+
+}
+
+void ServerApplication::Setup ()
+{
+    Urho3D::String time = Urho3D::Time::GetTimeStamp ();
+    time.Replace (':', ' ');
+    std::set_terminate (CustomTerminate);
+    ActivitiesApplication::Setup ();
+
+    engineParameters_ [Urho3D::EP_HEADLESS] = true;
+    engineParameters_ [Urho3D::EP_SOUND] = false;
+    // Worker threads are created in Start, because their count is taken from command line.
+    engineParameters_ [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters_ [Urho3D::EP_LOG_NAME] = "CastlesStrategyServer " + time + ".log";
+
+    if (!ParseServerArguments ())
+    {
+        ErrorExit ("Usage: CastlesStrategyServer [--map <name>] [--port <port>] "
+                "[--tick-rate <ticks per second>] [--worker-threads <count>] "
+                "[--network-update-fps <replications per second>] "
+                "[--record <match recording path>] [--replay <match recording path>]");
+    }
+}
+
+void ServerApplication::Start ()
+{
+    ActivitiesApplication::Start ();
+    CastlesStrategy::Unit::RegisterObject (context_);
+    CastlesStrategy::Village::RegisterObject (context_);
+
+    unsigned int workerThreads = workerThreads_ >= 0 ?
+            static_cast <unsigned int> (workerThreads_) : Urho3D::Max (Urho3D::GetNumPhysicalCPUs (), 1u) - 1;
+    if (workerThreads > 0)
+    {
+        context_->GetSubsystem <Urho3D::WorkQueue> ()->CreateThreads (workerThreads);
+    }
+    // Simulation uses fixed time step, so frames are limited only to avoid busy waiting between ticks.
+    context_->GetSubsystem <Urho3D::Engine> ()->SetMaxFps (tickRate_ * 2);
+    context_->GetSubsystem <Urho3D::Network> ()->SetUpdateFps (networkUpdateFps_);
+
+    if (replayPath_.Empty () && !context_->GetSubsystem <Urho3D::FileSystem> ()->FileExists (
+            "Data/" + CastlesStrategy::DEFAULT_MAPS_FOLDER + "/" + mapName_ + "/Map.xml"))
+    {
+        ErrorExit ("CastlesStrategyServer: map \"" + mapName_ + "\" is not exists!");
+        return;
+    }
+
+    SubscribeToEvent (CastlesStrategy::E_SHUTDOWN_ALL_ACTIVITIES,
+            URHO3D_HANDLER (ServerApplication, HandleShutdownAllActivities));
+
+    CastlesStrategy::ServerActivity *server = new CastlesStrategy::ServerActivity (context_);
+    server->SetMatchRecordingPath (recordPath_);
+    server->SetReplayPath (replayPath_);
+    if (!replayPath_.Empty ())
+    {
+        SetupActivityNextFrame (server);
+        return;
+    }
+
+    server->SetMapName (mapName_);
+    server->SetServerPort (serverPort_);
+    server->SetSimulationRate (tickRate_);
+    server->SetAutoStartWhenReady (true);
+    SetupActivityNextFrame (server);
+
+    URHO3D_LOGINFO ("CastlesStrategyServer: starting on port " + Urho3D::String (serverPort_) + " with map " +
+            mapName_ + ", " + Urho3D::String (tickRate_) + " ticks per second, " +
+            Urho3D::String (networkUpdateFps_) + " network updates per second and " +
+            Urho3D::String (workerThreads) + " worker threads.");
+}
+
+void ServerApplication::Stop ()
+{
+    ActivitiesApplication::Stop ();
+}
+
+bool ServerApplication::ParseServerArguments ()
+{
+    // Engine parses its own arguments too, so only long options are used here: "-p" is engine resource paths option.
+    const Urho3D::Vector <Urho3D::String> &arguments = Urho3D::GetArguments ();
+    for (unsigned index = 0; index < arguments.Size (); index++)
+    {
+        const Urho3D::String &argument = arguments [index];
+        if (!argument.StartsWith ("--"))
+        {
+            continue;
+        }
+
+        if (index + 1 >= arguments.Size ())
+        {
+            return false;
+        }
+
+        const Urho3D::String &value = arguments [++index];
+        if (argument == "--map")
+        {
+            mapName_ = value;
+        }
+        else if (argument == "--port")
+        {
+            serverPort_ = Urho3D::ToUInt (value);
+            if (serverPort_ == 0 || serverPort_ > Urho3D::M_MAX_UNSIGNED_SHORT)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--tick-rate")
+        {
+            tickRate_ = Urho3D::ToUInt (value);
+            if (tickRate_ == 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--worker-threads")
+        {
+            workerThreads_ = Urho3D::ToInt (value);
+            if (workerThreads_ < 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--network-update-fps")
+        {
+            networkUpdateFps_ = Urho3D::ToUInt (value);
+            if (networkUpdateFps_ == 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--record")
+        {
+            recordPath_ = value;
+        }
+        else if (argument == "--replay")
+        {
+            replayPath_ = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ServerApplication::HandleShutdownAllActivities (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData)
+{
+    StopAllActivitiesNextFrame ();
+    context_->GetSubsystem <Urho3D::Engine> ()->Exit ();
+}
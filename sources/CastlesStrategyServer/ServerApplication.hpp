@@ -0,0 +1,36 @@
+#pragma once
+#include <ActivitiesApplication/ActivitiesApplication.hpp>
+
+const unsigned int DEFAULT_SERVER_TICK_RATE = 30;
+/// Clients interpolate units motion, so scene can be replicated less often than simulation ticks.
+const unsigned int DEFAULT_SERVER_NETWORK_UPDATE_FPS = 30;
+const Urho3D::String DEFAULT_SERVER_MAP_NAME ("Default");
+
+/// Headless application, which runs only ServerActivity. Usage:
+/// CastlesStrategyServer [--map <name>] [--port <port>] [--tick-rate <ticks per second>] [--worker-threads <count>]
+///     [--network-update-fps <replications per second>] [--record <match recording path>]
+///     [--replay <match recording path>]
+/// In replay mode server does not accept connections, replays match as fast as possible and exits.
+class ServerApplication : public ActivitiesApplication::ActivitiesApplication
+{
+public:
+    explicit ServerApplication (Urho3D::Context *context);
+    virtual ~ServerApplication ();
+
+    virtual void Setup ();
+    virtual void Start ();
+    virtual void Stop ();
+
+private:
+    bool ParseServerArguments ();
+    void HandleShutdownAllActivities (Urho3D::StringHash eventType, Urho3D::VariantMap &eventData);
+
+    Urho3D::String mapName_;
+    unsigned int serverPort_;
+    unsigned int tickRate_;
+    unsigned int networkUpdateFps_;
+    /// Count of physical CPUs minus one if not specified.
+    int workerThreads_;
+    Urho3D::String recordPath_;
+    Urho3D::String replayPath_;
+};
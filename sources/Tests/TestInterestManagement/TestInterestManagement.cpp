@@ -0,0 +1,276 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/ReplicationState.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Model.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Navigation/CrowdManager.h>
+#include <Urho3D/Navigation/Navigable.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Unit/UnitType.hpp>
+
+#include <CastlesStrategy/Server/Activity/UnitsInterestFilter.hpp>
+#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
+#include <CastlesStrategy/Server/Managers/Map.hpp>
+#include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+Urho3D::Scene *SetupScene (Urho3D::Context *context);
+
+void SetupUnitsManager (CastlesStrategy::UnitsManager *unitsManager, Urho3D::Context *context);
+void SetupMap (CastlesStrategy::Map *map, Urho3D::Context *context);
+
+void StartReplication (Urho3D::SceneReplicationState &sceneState, Urho3D::Node *node);
+/// Does the same with replication state as connection does after sending scene update.
+void MarkReplicationSent (Urho3D::SceneReplicationState &sceneState);
+unsigned int GetUnitIndex (const CastlesStrategy::UnitsManager *unitsManager, const CastlesStrategy::Unit *unit);
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    // Replication states are referenced by scene nodes, so they are destructed after scene.
+    Urho3D::SceneReplicationState sceneState;
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    CastlesStrategy::Unit::RegisterObject (context);
+
+    SetupEngine (engine);
+    Urho3D::SharedPtr <Urho3D::Scene> scene (SetupScene (context));
+
+    CastlesStrategy::ManagersHub managersHub (scene);
+    CastlesStrategy::Map *map = dynamic_cast <CastlesStrategy::Map *> (managersHub.GetManager (CastlesStrategy::MI_MAP));
+    SetupMap (map, context);
+
+    CastlesStrategy::UnitsManager *unitsManager =
+            dynamic_cast <CastlesStrategy::UnitsManager *> (managersHub.GetManager (CastlesStrategy::MI_UNITS_MANAGER));
+    SetupUnitsManager (unitsManager, context);
+
+    const float TIME_STEP = 1.0f / 60.0f;
+    const unsigned int TICKS = 120;
+
+    // Second player unit starts near second player spawns, so it is out of first player units vision range.
+    Urho3D::SharedPtr <CastlesStrategy::Unit> ownUnit (unitsManager->GetUnit (
+            unitsManager->SpawnUnit (0, true, 1)->GetID ()));
+    Urho3D::SharedPtr <CastlesStrategy::Unit> enemyUnit (unitsManager->GetUnit (
+            unitsManager->SpawnUnit (0, false, 1)->GetID ()));
+
+    managersHub.HandleUpdate (TIME_STEP);
+    scene->Update (TIME_STEP);
+
+    // Both units are already replicated to first player.
+    StartReplication (sceneState, ownUnit->GetNode ());
+    StartReplication (sceneState, enemyUnit->GetNode ());
+    scene->PrepareNetworkUpdate ();
+    MarkReplicationSent (sceneState);
+
+    CastlesStrategy::UnitsInterestFilter filter;
+    Urho3D::Vector3 enemyStartPosition = enemyUnit->GetNode ()->GetWorldPosition ();
+    unsigned int ownUnitUpdates = 0;
+    Urho3D::PODVector <unsigned int> spawnedObjectsIDs;
+    Urho3D::PODVector <unsigned int> sentSpawnedObjectsIDs;
+    spawnedObjectsIDs.Push (ownUnit->GetNode ()->GetID ());
+    spawnedObjectsIDs.Push (enemyUnit->GetNode ()->GetID ());
+
+    for (unsigned int tick = 0; tick < TICKS; tick++)
+    {
+        managersHub.HandleUpdate (TIME_STEP);
+        scene->Update (TIME_STEP);
+        filter.Apply (scene, &sceneState, unitsManager, true);
+        // Network subsystem prepares network update after scene update, right before sending it.
+        scene->PrepareNetworkUpdate ();
+
+        if (unitsManager->IsUnitVisibleForTeam (GetUnitIndex (unitsManager, enemyUnit), true))
+        {
+            URHO3D_LOGERROR ("Enemy unit must be out of first player vision range!");
+            return 1;
+        }
+
+        if (sceneState.dirtyNodes_.Contains (enemyUnit->GetNode ()->GetID ()))
+        {
+            URHO3D_LOGERROR ("Hidden enemy unit changes must not be sent, tick " + Urho3D::String (tick) + "!");
+            return 2;
+        }
+
+        if (sceneState.dirtyNodes_.Contains (ownUnit->GetNode ()->GetID ()))
+        {
+            ownUnitUpdates++;
+        }
+
+        filter.FilterSpawnedObjects (scene, spawnedObjectsIDs, sentSpawnedObjectsIDs);
+        spawnedObjectsIDs.Clear ();
+        MarkReplicationSent (sceneState);
+    }
+
+    if (sentSpawnedObjectsIDs.Size () != 1 || sentSpawnedObjectsIDs.Front () != ownUnit->GetNode ()->GetID ())
+    {
+        URHO3D_LOGERROR ("Only id of own unit must be sent as spawned object id while enemy unit is hidden!");
+        return 5;
+    }
+
+    URHO3D_LOGINFO ("Result enemy unit position: " + enemyUnit->GetNode ()->GetWorldPosition ().ToString ());
+    URHO3D_LOGINFO ("Result own unit updates: " + Urho3D::String (ownUnitUpdates));
+
+    if ((enemyUnit->GetNode ()->GetWorldPosition () - enemyStartPosition).Length () < 0.1f)
+    {
+        URHO3D_LOGERROR ("Enemy unit must move, otherwise test checks nothing!");
+        return 3;
+    }
+
+    if (ownUnitUpdates == 0)
+    {
+        URHO3D_LOGERROR ("Own unit changes must be sent!");
+        return 4;
+    }
+
+    // Units go to each other by the same route, so enemy walks into vision and changes, accumulated while it was
+    // hidden, must be sent together with its spawned object id.
+    const unsigned int MAX_REVEAL_TICKS = 3600;
+    bool isRevealed = false;
+    sentSpawnedObjectsIDs.Clear ();
+
+    for (unsigned int tick = 0; tick < MAX_REVEAL_TICKS && !isRevealed; tick++)
+    {
+        managersHub.HandleUpdate (TIME_STEP);
+        scene->Update (TIME_STEP);
+        filter.Apply (scene, &sceneState, unitsManager, true);
+        scene->PrepareNetworkUpdate ();
+
+        isRevealed = unitsManager->IsUnitVisibleForTeam (GetUnitIndex (unitsManager, enemyUnit), true);
+        if (isRevealed)
+        {
+            unsigned int enemyNodeId = enemyUnit->GetNode ()->GetID ();
+            URHO3D_LOGINFO ("Result enemy unit revealed at tick " + Urho3D::String (tick) + ".");
+
+            if (!sceneState.dirtyNodes_.Contains (enemyNodeId) ||
+                    sceneState.nodeStates_ [enemyNodeId].dirtyAttributes_.Count () == 0)
+            {
+                URHO3D_LOGERROR ("Revealed enemy unit must be queued with changes, accumulated while it was hidden!");
+                return 6;
+            }
+
+            filter.FilterSpawnedObjects (scene, spawnedObjectsIDs, sentSpawnedObjectsIDs);
+            if (!sentSpawnedObjectsIDs.Contains (enemyNodeId))
+            {
+                URHO3D_LOGERROR ("Spawned object id of enemy unit must be sent when enemy unit is revealed!");
+                return 7;
+            }
+        }
+        MarkReplicationSent (sceneState);
+    }
+
+    if (!isRevealed)
+    {
+        URHO3D_LOGERROR ("Enemy unit must walk into first player vision range!");
+        return 8;
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestInterestManagement.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Scene *SetupScene (Urho3D::Context *context)
+{
+    Urho3D::Scene *scene = new Urho3D::Scene (context);
+    Urho3D::Node *planeNode = scene->CreateChild ("Plane");
+
+    planeNode->SetPosition ({50.0f, 0.0f, 50.0f});
+    planeNode->SetScale ({100.0f, 1.0f, 100.0f});
+    planeNode->CreateComponent <Urho3D::Navigable> ();
+
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::StaticModel *model = planeNode->CreateComponent <Urho3D::StaticModel> ();
+    model->SetModel (cache->GetResource <Urho3D::Model> ("Plane.mdl"));
+
+    Urho3D::NavigationMesh *navMesh = scene->CreateComponent <Urho3D::NavigationMesh> ();
+    navMesh->Build ();
+    scene->CreateComponent <Urho3D::CrowdManager> ();
+    return scene;
+}
+
+void SetupUnitsManager (CastlesStrategy::UnitsManager *unitsManager, Urho3D::Context *context)
+{
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    unitsManager->LoadUnitsTypesFromXML (cache->GetResource <Urho3D::XMLFile> ("TestUnitTypes.xml")->GetRoot ());
+    unitsManager->LoadSpawnsFromXML (cache->GetResource <Urho3D::XMLFile> ("TestMap.xml")->GetRoot ());
+}
+
+void SetupMap (CastlesStrategy::Map *map, Urho3D::Context *context)
+{
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::XMLElement xml = cache->GetResource <Urho3D::XMLFile> ("TestMap.xml")->GetRoot ();
+
+    map->SetSize (xml.GetIntVector2 ("size"));
+    map->LoadRoutesFromXML (xml);
+}
+
+void StartReplication (Urho3D::SceneReplicationState &sceneState, Urho3D::Node *node)
+{
+    Urho3D::NodeReplicationState &nodeState = sceneState.nodeStates_ [node->GetID ()];
+    nodeState.connection_ = nullptr;
+    nodeState.sceneState_ = &sceneState;
+    nodeState.node_ = node;
+    node->AddReplicationState (&nodeState);
+}
+
+void MarkReplicationSent (Urho3D::SceneReplicationState &sceneState)
+{
+    for (auto &nodeState : sceneState.nodeStates_)
+    {
+        if (sceneState.dirtyNodes_.Contains (nodeState.first_))
+        {
+            nodeState.second_.markedDirty_ = false;
+            nodeState.second_.dirtyAttributes_.ClearAll ();
+        }
+    }
+    sceneState.dirtyNodes_.Clear ();
+}
+
+unsigned int GetUnitIndex (const CastlesStrategy::UnitsManager *unitsManager, const CastlesStrategy::Unit *unit)
+{
+    const CastlesStrategy::UnitsState &unitsState = unitsManager->GetUnitsState ();
+    for (unsigned int index = 0; index < unitsState.Size (); index++)
+    {
+        if (unitsState.units_ [index] == unit)
+        {
+            return index;
+        }
+    }
+    return Urho3D::M_MAX_UNSIGNED;
+}
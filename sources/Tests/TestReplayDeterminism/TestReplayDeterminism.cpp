@@ -0,0 +1,298 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Model.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Navigation/NavigationMesh.h>
+#include <Urho3D/Navigation/CrowdManager.h>
+#include <Urho3D/Navigation/Navigable.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+#include <CastlesStrategy/Shared/Unit/UnitType.hpp>
+#include <CastlesStrategy/Shared/Village/Village.hpp>
+
+#include <CastlesStrategy/Server/Managers/VillagesManager.hpp>
+#include <CastlesStrategy/Server/Managers/UnitsManager.hpp>
+#include <CastlesStrategy/Server/Managers/PlayersManager.hpp>
+#include <CastlesStrategy/Server/Managers/Map.hpp>
+#include <CastlesStrategy/Server/Managers/ManagersHub.hpp>
+#include <CastlesStrategy/Server/Replay/MatchRecording.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+Urho3D::Scene *SetupScene (Urho3D::Context *context);
+
+void SetupManagersHub (CastlesStrategy::ManagersHub *managersHub, Urho3D::Context *context, unsigned int startCoins);
+void RecordMatch (CastlesStrategy::MatchRecording &recording, const CastlesStrategy::UnitsManager *unitsManager);
+void AddInput (CastlesStrategy::MatchRecording &recording, CastlesStrategy::MatchInputType type, bool firstPlayer,
+        unsigned int unitType, unsigned int spawnId);
+
+void ReplayMatch (CastlesStrategy::ManagersHub *managersHub, Urho3D::Scene *scene,
+        const CastlesStrategy::MatchRecording &recording);
+bool IsUnitsStatesEqual (const CastlesStrategy::UnitsState &first, const CastlesStrategy::UnitsState &second);
+
+const unsigned int START_COINS = 1000;
+const unsigned int RANDOM_SEED = 12345;
+const float TIME_STEP = 1.0f / 60.0f;
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    CastlesStrategy::Unit::RegisterObject (context);
+    CastlesStrategy::Village::RegisterObject (context);
+    SetupEngine (engine);
+
+    Urho3D::SharedPtr <Urho3D::Scene> firstScene (SetupScene (context));
+    CastlesStrategy::ManagersHub firstManagersHub (firstScene);
+    SetupManagersHub (&firstManagersHub, context, START_COINS);
+
+    Urho3D::SharedPtr <Urho3D::Scene> secondScene (SetupScene (context));
+    CastlesStrategy::ManagersHub secondManagersHub (secondScene);
+    SetupManagersHub (&secondManagersHub, context, START_COINS);
+
+    CastlesStrategy::UnitsManager *firstUnitsManager = dynamic_cast <CastlesStrategy::UnitsManager *> (
+            firstManagersHub.GetManager (CastlesStrategy::MI_UNITS_MANAGER));
+    CastlesStrategy::UnitsManager *secondUnitsManager = dynamic_cast <CastlesStrategy::UnitsManager *> (
+            secondManagersHub.GetManager (CastlesStrategy::MI_UNITS_MANAGER));
+
+    CastlesStrategy::MatchRecording recording;
+    RecordMatch (recording, firstUnitsManager);
+
+    // Replay is always done from saved recording, so serialization is the part of checked path too.
+    Urho3D::VectorBuffer buffer;
+    if (!recording.Save (buffer))
+    {
+        URHO3D_LOGERROR ("Can not save match recording!");
+        return 1;
+    }
+
+    buffer.Seek (0);
+    CastlesStrategy::MatchRecording loadedRecording;
+    loadedRecording.Load (buffer);
+
+    if (loadedRecording.GetTicksCount () != recording.GetTicksCount () ||
+            loadedRecording.GetInputs ().Size () != recording.GetInputs ().Size () ||
+            loadedRecording.GetRandomSeed () != RANDOM_SEED)
+    {
+        URHO3D_LOGERROR ("Loaded match recording differs from saved one!");
+        return 2;
+    }
+
+    ReplayMatch (&firstManagersHub, firstScene, loadedRecording);
+    ReplayMatch (&secondManagersHub, secondScene, loadedRecording);
+
+    const CastlesStrategy::UnitsState &firstState = firstUnitsManager->GetUnitsState ();
+    const CastlesStrategy::UnitsState &secondState = secondUnitsManager->GetUnitsState ();
+    URHO3D_LOGINFO ("Result first replay units count: " + Urho3D::String (firstState.Size ()));
+    URHO3D_LOGINFO ("Result second replay units count: " + Urho3D::String (secondState.Size ()));
+
+    // Spawns are always alive, so replay without spawned units means that inputs were not applied.
+    unsigned int spawnsCount = 0;
+    for (unsigned int index = 0; index < firstState.Size (); index++)
+    {
+        if (firstState.unitTypes_ [index] == firstUnitsManager->GetSpawnsUnitType ())
+        {
+            spawnsCount++;
+        }
+    }
+
+    if (firstState.Size () == spawnsCount)
+    {
+        URHO3D_LOGERROR ("Replayed inputs must spawn units!");
+        return 3;
+    }
+
+    if (!IsUnitsStatesEqual (firstState, secondState))
+    {
+        return 4;
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestReplayDeterminism.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Scene *SetupScene (Urho3D::Context *context)
+{
+    Urho3D::Scene *scene = new Urho3D::Scene (context);
+    Urho3D::Node *planeNode = scene->CreateChild ("Plane");
+
+    planeNode->SetPosition ({50.0f, 0.0f, 50.0f});
+    planeNode->SetScale ({100.0f, 1.0f, 100.0f});
+    planeNode->CreateComponent <Urho3D::Navigable> ();
+
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::StaticModel *model = planeNode->CreateComponent <Urho3D::StaticModel> ();
+    model->SetModel (cache->GetResource <Urho3D::Model> ("Plane.mdl"));
+
+    Urho3D::NavigationMesh *navMesh = scene->CreateComponent <Urho3D::NavigationMesh> ();
+    navMesh->Build ();
+    scene->CreateComponent <Urho3D::CrowdManager> ();
+    return scene;
+}
+
+void SetupManagersHub (CastlesStrategy::ManagersHub *managersHub, Urho3D::Context *context, unsigned int startCoins)
+{
+    Urho3D::ResourceCache *cache = context->GetSubsystem <Urho3D::ResourceCache> ();
+    Urho3D::XMLElement mapXML = cache->GetResource <Urho3D::XMLFile> ("TestMap.xml")->GetRoot ();
+
+    CastlesStrategy::Map *map = dynamic_cast <CastlesStrategy::Map *> (managersHub->GetManager (CastlesStrategy::MI_MAP));
+    map->SetSize (mapXML.GetIntVector2 ("size"));
+    map->LoadRoutesFromXML (mapXML);
+
+    CastlesStrategy::UnitsManager *unitsManager =
+            dynamic_cast <CastlesStrategy::UnitsManager *> (managersHub->GetManager (CastlesStrategy::MI_UNITS_MANAGER));
+    unitsManager->LoadUnitsTypesFromXML (cache->GetResource <Urho3D::XMLFile> ("TestUnitTypes.xml")->GetRoot ());
+    unitsManager->LoadSpawnsFromXML (mapXML);
+
+    CastlesStrategy::VillagesManager *villagesManager =
+            dynamic_cast <CastlesStrategy::VillagesManager *> (managersHub->GetManager (CastlesStrategy::MI_VILLAGES_MANAGER));
+    villagesManager->LoadVillagesFromXML (mapXML);
+
+    CastlesStrategy::PlayersManager *playersManager =
+            dynamic_cast <CastlesStrategy::PlayersManager *> (managersHub->GetManager (CastlesStrategy::MI_PLAYERS_MANAGER));
+    playersManager->SetFirstPlayer (CastlesStrategy::Player (managersHub));
+    playersManager->GetFirstPlayer ().SetCoins (startCoins);
+    playersManager->SetSecondPlayer (CastlesStrategy::Player (managersHub));
+    playersManager->GetSecondPlayer ().SetCoins (startCoins);
+}
+
+void RecordMatch (CastlesStrategy::MatchRecording &recording, const CastlesStrategy::UnitsManager *unitsManager)
+{
+    // Both managers hubs are set up the same way, so spawns have the same IDs in both scenes.
+    const unsigned int FIRST_SPAWN_ROUTE_0 = unitsManager->GetSpawn (0, true)->GetID ();
+    const unsigned int FIRST_SPAWN_ROUTE_1 = unitsManager->GetSpawn (1, true)->GetID ();
+    const unsigned int SECOND_SPAWN_ROUTE_0 = unitsManager->GetSpawn (0, false)->GetID ();
+    const unsigned int SECOND_SPAWN_ROUTE_1 = unitsManager->GetSpawn (1, false)->GetID ();
+
+    const unsigned int STRONG_UNIT_TYPE = 1;
+    const unsigned int WEAK_UNIT_TYPE = 2;
+    const unsigned int RECRUITMENT_TICKS = 20 * 60;
+    const unsigned int WAVES_COUNT = 3;
+
+    recording.Setup ("TestMap", RANDOM_SEED);
+    for (unsigned int wave = 0; wave < WAVES_COUNT; wave++)
+    {
+        AddInput (recording, CastlesStrategy::MIT_ADD_ORDER, true, STRONG_UNIT_TYPE, 0);
+        AddInput (recording, CastlesStrategy::MIT_ADD_ORDER, true, WEAK_UNIT_TYPE, 0);
+        AddInput (recording, CastlesStrategy::MIT_ADD_ORDER, false, WEAK_UNIT_TYPE, 0);
+        AddInput (recording, CastlesStrategy::MIT_ADD_ORDER, false, WEAK_UNIT_TYPE, 0);
+
+        for (unsigned int tick = 0; tick < RECRUITMENT_TICKS; tick++)
+        {
+            recording.AddTick (TIME_STEP);
+        }
+
+        AddInput (recording, CastlesStrategy::MIT_SPAWN_UNIT, true, STRONG_UNIT_TYPE, FIRST_SPAWN_ROUTE_0);
+        AddInput (recording, CastlesStrategy::MIT_SPAWN_UNIT, true, WEAK_UNIT_TYPE, FIRST_SPAWN_ROUTE_1);
+        AddInput (recording, CastlesStrategy::MIT_SPAWN_UNIT, false, WEAK_UNIT_TYPE, SECOND_SPAWN_ROUTE_0);
+        AddInput (recording, CastlesStrategy::MIT_SPAWN_UNIT, false, WEAK_UNIT_TYPE, SECOND_SPAWN_ROUTE_1);
+    }
+
+    for (unsigned int tick = 0; tick < RECRUITMENT_TICKS; tick++)
+    {
+        recording.AddTick (TIME_STEP);
+    }
+}
+
+void AddInput (CastlesStrategy::MatchRecording &recording, CastlesStrategy::MatchInputType type, bool firstPlayer,
+        unsigned int unitType, unsigned int spawnId)
+{
+    CastlesStrategy::MatchInput input;
+    input.tick_ = 0;
+    input.type_ = type;
+    input.firstPlayer_ = firstPlayer;
+    input.unitType_ = unitType;
+    input.spawnId_ = spawnId;
+    recording.AddInput (input);
+}
+
+void ReplayMatch (CastlesStrategy::ManagersHub *managersHub, Urho3D::Scene *scene,
+        const CastlesStrategy::MatchRecording &recording)
+{
+    dynamic_cast <CastlesStrategy::UnitsManager *> (managersHub->GetManager (CastlesStrategy::MI_UNITS_MANAGER))->
+            SetRandomSeed (recording.GetRandomSeed ());
+
+    const Urho3D::PODVector <float> &timeSteps = recording.GetTicksTimeSteps ();
+    const Urho3D::PODVector <CastlesStrategy::MatchInput> &inputs = recording.GetInputs ();
+    unsigned int nextInputIndex = 0;
+
+    for (unsigned int tick = 0; tick <= timeSteps.Size (); tick++)
+    {
+        while (nextInputIndex < inputs.Size () && inputs [nextInputIndex].tick_ == tick)
+        {
+            CastlesStrategy::ApplyMatchInput (managersHub, inputs [nextInputIndex]);
+            nextInputIndex++;
+        }
+
+        if (tick < timeSteps.Size ())
+        {
+            managersHub->HandleUpdate (timeSteps [tick]);
+            scene->Update (timeSteps [tick]);
+        }
+    }
+}
+
+bool IsUnitsStatesEqual (const CastlesStrategy::UnitsState &first, const CastlesStrategy::UnitsState &second)
+{
+    if (first.Size () != second.Size ())
+    {
+        URHO3D_LOGERROR ("Replays finished with different units count: " + Urho3D::String (first.Size ()) +
+                " and " + Urho3D::String (second.Size ()) + "!");
+        return false;
+    }
+
+    for (unsigned int index = 0; index < first.Size (); index++)
+    {
+        if (first.units_ [index]->GetID () != second.units_ [index]->GetID () ||
+                first.unitTypes_ [index] != second.unitTypes_ [index] ||
+                first.belongsToFirst_ [index] != second.belongsToFirst_ [index] ||
+                first.hp_ [index] != second.hp_ [index] ||
+                first.positions_ [index] != second.positions_ [index])
+        {
+            URHO3D_LOGERROR ("Replays finished with different states of unit with index " + Urho3D::String (index) +
+                    ": " + Urho3D::String (first.units_ [index]->GetID ()) + " at " +
+                    first.positions_ [index].ToString () + " with " + Urho3D::String (first.hp_ [index]) + " hp and " +
+                    Urho3D::String (second.units_ [index]->GetID ()) + " at " +
+                    second.positions_ [index].ToString () + " with " + Urho3D::String (second.hp_ [index]) + " hp!");
+            return false;
+        }
+    }
+    return true;
+}
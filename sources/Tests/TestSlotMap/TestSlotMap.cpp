@@ -0,0 +1,133 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Utils/UniversalException.hpp>
+#include <Utils/SlotMap.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    SetupEngine (engine);
+
+    SlotMap slotMap;
+    unsigned int firstHandle = slotMap.Allocate (0);
+    unsigned int secondHandle = slotMap.Allocate (1);
+    unsigned int thirdHandle = slotMap.Allocate (2);
+
+    if (slotMap.Resolve (firstHandle) != 0 || slotMap.Resolve (secondHandle) != 1 || slotMap.Resolve (thirdHandle) != 2)
+    {
+        URHO3D_LOGERROR ("Allocated handles must resolve to their dense indices!");
+        return 1;
+    }
+
+    // Emulates removal by swap with last: third unit moves to index of removed second unit.
+    slotMap.Release (secondHandle);
+    slotMap.Relocate (thirdHandle, 1);
+
+    if (slotMap.Resolve (secondHandle) != Urho3D::M_MAX_UNSIGNED || slotMap.Resolve (thirdHandle) != 1 ||
+            slotMap.Resolve (firstHandle) != 0)
+    {
+        URHO3D_LOGERROR ("Released handle must be stale and relocated handle must resolve to new index!");
+        return 2;
+    }
+
+    unsigned int reusedHandle = slotMap.Allocate (2);
+    URHO3D_LOGINFO ("Result released handle: " + Urho3D::String (secondHandle) + ", reused handle: " +
+            Urho3D::String (reusedHandle) + ".");
+
+    if (reusedHandle == secondHandle || slotMap.Resolve (reusedHandle) != 2 ||
+            slotMap.Resolve (secondHandle) != Urho3D::M_MAX_UNSIGNED)
+    {
+        URHO3D_LOGERROR ("Stale handle must not resolve to unit that reused its slot!");
+        return 3;
+    }
+
+    // Double release through stale handle must not free slot of its new owner.
+    slotMap.Release (secondHandle);
+    if (slotMap.Resolve (reusedHandle) != 2 || slotMap.Allocate (3) == reusedHandle)
+    {
+        URHO3D_LOGERROR ("Release of stale handle must be ignored!");
+        return 4;
+    }
+
+    bool relocateThrown = false;
+    try
+    {
+        slotMap.Relocate (secondHandle, 0);
+    }
+    catch (...)
+    {
+        relocateThrown = true;
+    }
+
+    if (!relocateThrown || slotMap.Resolve (firstHandle) != 0)
+    {
+        URHO3D_LOGERROR ("Expected exception in Relocate when handle is stale!");
+        return 5;
+    }
+
+    slotMap.Clear ();
+    const unsigned int MAX_SLOTS = 0xFFFF;
+    for (unsigned int index = 0; index < MAX_SLOTS; index++)
+    {
+        slotMap.Allocate (index);
+    }
+
+    bool overflowThrown = false;
+    try
+    {
+        slotMap.Allocate (MAX_SLOTS);
+    }
+    catch (...)
+    {
+        overflowThrown = true;
+    }
+
+    if (!overflowThrown)
+    {
+        URHO3D_LOGERROR ("Expected exception in Allocate when slots limit is reached!");
+        return 6;
+    }
+
+    if (slotMap.Resolve (Urho3D::M_MAX_UNSIGNED) != Urho3D::M_MAX_UNSIGNED)
+    {
+        URHO3D_LOGERROR ("M_MAX_UNSIGNED must never be a valid handle!");
+        return 7;
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestSlotMap.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
@@ -0,0 +1,277 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Client/Ingame/DataManager.hpp>
+#include <CastlesStrategy/Client/Ingame/UnitMotionInterpolator.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+
+Urho3D::Node *CreateUnit (Urho3D::Scene *scene, float interpolationDelay, float maxExtrapolationTime);
+/// Moves unit node by server step on even frames, like server sends transforms with half of client FPS.
+void UpdateUnit (Urho3D::Node *unitNode, unsigned int frame, bool isMoving);
+float GetPrefabX (Urho3D::Node *unitNode);
+
+/// Loads real unit prefab, which is updated by scene like on client.
+Urho3D::Node *CreateUnitWithPrefab (Urho3D::Scene *scene, const Urho3D::String &prefabPath);
+void UpdateScene (Urho3D::Scene *scene, Urho3D::Node *unitNode, unsigned int frame);
+/// Returns distance between unit node and its prefab without prefab offset.
+float GetPrefabLag (Urho3D::Node *unitNode, const Urho3D::Vector3 &prefabOffset);
+
+const float TIME_STEP = 1.0f / 60.0f;
+const float SERVER_STEP = 0.1f;
+const float SPEED = SERVER_STEP / (2.0f * TIME_STEP);
+const float TOLERANCE = 0.01f;
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    CastlesStrategy::Unit::RegisterObject (context);
+    CastlesStrategy::UnitMotionInterpolator::RegisterObject (context);
+    SetupEngine (engine);
+    Urho3D::SharedPtr <Urho3D::Scene> scene (new Urho3D::Scene (context));
+
+    const float INTERPOLATION_DELAY = 0.1f;
+    const unsigned int WARM_UP_FRAMES = 30;
+    const unsigned int MOVING_FRAMES = 120;
+    Urho3D::Node *unitNode = CreateUnit (scene, INTERPOLATION_DELAY, CastlesStrategy::DEFAULT_MOTION_MAX_EXTRAPOLATION_TIME);
+
+    float previousPrefabX = GetPrefabX (unitNode);
+    for (unsigned int frame = 0; frame < MOVING_FRAMES; frame++)
+    {
+        UpdateUnit (unitNode, frame, true);
+        float prefabX = GetPrefabX (unitNode);
+        float lag = unitNode->GetWorldPosition ().x_ - prefabX;
+
+        if (frame >= WARM_UP_FRAMES && (Urho3D::Abs (prefabX - previousPrefabX - SPEED * TIME_STEP) > TOLERANCE ||
+                lag < SPEED * INTERPOLATION_DELAY - SERVER_STEP || lag > SPEED * INTERPOLATION_DELAY + TOLERANCE))
+        {
+            URHO3D_LOGERROR ("Frame " + Urho3D::String (frame) + ": prefab moved by " +
+                    Urho3D::String (prefabX - previousPrefabX) + " with lag " + Urho3D::String (lag) +
+                    ", but it must move smoothly with interpolation delay!");
+            return 1;
+        }
+        previousPrefabX = prefabX;
+    }
+
+    // Server does not send transforms of standing unit, prefab must stop at the last position without overshoot.
+    const unsigned int PAUSE_FRAMES = 60;
+    for (unsigned int frame = 0; frame < PAUSE_FRAMES; frame++)
+    {
+        UpdateUnit (unitNode, frame, false);
+        if (GetPrefabX (unitNode) > unitNode->GetWorldPosition ().x_ + TOLERANCE)
+        {
+            URHO3D_LOGERROR ("Prefab must not move further than stopped unit!");
+            return 2;
+        }
+    }
+
+    URHO3D_LOGINFO ("Result prefab x after pause: " + Urho3D::String (GetPrefabX (unitNode)) + ", unit x: " +
+            Urho3D::String (unitNode->GetWorldPosition ().x_) + ".");
+    if (Urho3D::Abs (GetPrefabX (unitNode) - unitNode->GetWorldPosition ().x_) > TOLERANCE)
+    {
+        URHO3D_LOGERROR ("Prefab must reach position of stopped unit!");
+        return 3;
+    }
+
+    // Motion after pause must keep its speed instead of being stretched over the whole pause.
+    const unsigned int RESUME_FRAMES = 60;
+    const unsigned int RESUME_DELAY_FRAMES = 12;
+    previousPrefabX = GetPrefabX (unitNode);
+
+    for (unsigned int frame = 0; frame < RESUME_FRAMES; frame++)
+    {
+        UpdateUnit (unitNode, frame, true);
+        float prefabX = GetPrefabX (unitNode);
+        float prefabStep = prefabX - previousPrefabX;
+
+        if (prefabStep > SPEED * TIME_STEP + TOLERANCE ||
+                (frame >= RESUME_DELAY_FRAMES && Urho3D::Abs (prefabStep - SPEED * TIME_STEP) > TOLERANCE))
+        {
+            URHO3D_LOGERROR ("Frame " + Urho3D::String (frame) + " after pause: prefab moved by " +
+                    Urho3D::String (prefabStep) + ", but expected " + Urho3D::String (SPEED * TIME_STEP) + "!");
+            return 4;
+        }
+        previousPrefabX = prefabX;
+    }
+
+    // Without interpolation delay late transform is extrapolated, but not further than max extrapolation time.
+    const float MAX_EXTRAPOLATION_TIME = 0.02f;
+    Urho3D::Node *extrapolatedUnitNode = CreateUnit (scene, 0.0f, MAX_EXTRAPOLATION_TIME);
+
+    for (unsigned int frame = 0; frame < WARM_UP_FRAMES; frame++)
+    {
+        UpdateUnit (extrapolatedUnitNode, frame, true);
+    }
+
+    UpdateUnit (extrapolatedUnitNode, WARM_UP_FRAMES, false);
+    float extrapolation = GetPrefabX (extrapolatedUnitNode) - extrapolatedUnitNode->GetWorldPosition ().x_;
+    URHO3D_LOGINFO ("Result extrapolation: " + Urho3D::String (extrapolation) + ".");
+
+    if (Urho3D::Abs (extrapolation - SPEED * MAX_EXTRAPOLATION_TIME) > TOLERANCE)
+    {
+        URHO3D_LOGERROR ("Late transform must be extrapolated by " + Urho3D::String (SPEED * MAX_EXTRAPOLATION_TIME) +
+                ", but extrapolated by " + Urho3D::String (extrapolation) + "!");
+        return 5;
+    }
+
+    for (unsigned int frame = 0; frame < PAUSE_FRAMES; frame++)
+    {
+        UpdateUnit (extrapolatedUnitNode, frame, false);
+    }
+
+    if (Urho3D::Abs (GetPrefabX (extrapolatedUnitNode) - extrapolatedUnitNode->GetWorldPosition ().x_) > TOLERANCE)
+    {
+        URHO3D_LOGERROR ("Prefab of stopped unit must return from extrapolated position to unit position!");
+        return 6;
+    }
+
+    // Pooled unit is disabled on death and enabled at spawn, its prefab must appear there without sliding.
+    Urho3D::SharedPtr <Urho3D::Scene> prefabScene (new Urho3D::Scene (context));
+    Urho3D::Node *pooledUnitNode = CreateUnitWithPrefab (prefabScene, "DefaultUnits/Knight/Prefab.xml");
+    Urho3D::Node *prefab = pooledUnitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME);
+    if (prefab == nullptr || !prefab->HasComponent <CastlesStrategy::UnitMotionInterpolator> ())
+    {
+        URHO3D_LOGERROR ("Real unit prefab must be created with motion interpolator!");
+        return 7;
+    }
+
+    const Urho3D::Vector3 prefabOffset = prefab->GetPosition ();
+    const float MAX_LAG = SPEED * CastlesStrategy::DEFAULT_MOTION_INTERPOLATION_DELAY + SERVER_STEP + TOLERANCE;
+    for (unsigned int frame = 0; frame < MOVING_FRAMES; frame++)
+    {
+        UpdateScene (prefabScene, pooledUnitNode, frame);
+    }
+
+    pooledUnitNode->SetEnabled (false);
+    CastlesStrategy::DataManager::UpdateObjectPrefabEnabled (pooledUnitNode);
+    for (unsigned int frame = 0; frame < PAUSE_FRAMES; frame++)
+    {
+        prefabScene->Update (TIME_STEP);
+    }
+
+    pooledUnitNode->Translate ({-30.0f, 0.0f, 10.0f});
+    pooledUnitNode->SetEnabled (true);
+    CastlesStrategy::DataManager::UpdateObjectPrefabEnabled (pooledUnitNode);
+
+    for (unsigned int frame = 0; frame < MOVING_FRAMES; frame++)
+    {
+        UpdateScene (prefabScene, pooledUnitNode, frame);
+        float lag = GetPrefabLag (pooledUnitNode, prefabOffset);
+        if (lag > MAX_LAG)
+        {
+            URHO3D_LOGERROR ("Frame " + Urho3D::String (frame) + " after respawn: prefab lags by " +
+                    Urho3D::String (lag) + ", but old position must not be interpolated!");
+            return 8;
+        }
+    }
+
+    // Position of respawned unit can be replicated without disabling, if unit died and respawned between updates.
+    pooledUnitNode->Translate ({30.0f, 0.0f, -10.0f});
+    for (unsigned int frame = 0; frame < MOVING_FRAMES; frame++)
+    {
+        UpdateScene (prefabScene, pooledUnitNode, frame);
+        float lag = GetPrefabLag (pooledUnitNode, prefabOffset);
+        if (lag > MAX_LAG)
+        {
+            URHO3D_LOGERROR ("Frame " + Urho3D::String (frame) + " after teleport: prefab lags by " +
+                    Urho3D::String (lag) + ", but teleport must not be interpolated!");
+            return 9;
+        }
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestUnitMotionInterpolator.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Node *CreateUnit (Urho3D::Scene *scene, float interpolationDelay, float maxExtrapolationTime)
+{
+    Urho3D::Node *unitNode = scene->CreateChild ("Unit");
+    Urho3D::Node *prefabNode = unitNode->CreateChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME, Urho3D::LOCAL);
+
+    CastlesStrategy::UnitMotionInterpolator *interpolator =
+            prefabNode->CreateComponent <CastlesStrategy::UnitMotionInterpolator> (Urho3D::LOCAL);
+    interpolator->SetInterpolationDelay (interpolationDelay);
+    interpolator->SetMaxExtrapolationTime (maxExtrapolationTime);
+    return unitNode;
+}
+
+void UpdateUnit (Urho3D::Node *unitNode, unsigned int frame, bool isMoving)
+{
+    if (isMoving && frame % 2 == 0)
+    {
+        unitNode->Translate ({SERVER_STEP, 0.0f, 0.0f});
+    }
+    unitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME)->GetComponent <CastlesStrategy::UnitMotionInterpolator> ()->Update (TIME_STEP);
+}
+
+float GetPrefabX (Urho3D::Node *unitNode)
+{
+    return unitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME)->GetWorldPosition ().x_;
+}
+
+Urho3D::Node *CreateUnitWithPrefab (Urho3D::Scene *scene, const Urho3D::String &prefabPath)
+{
+    Urho3D::Node *unitNode = scene->CreateChild ("Unit");
+    unitNode->CreateComponent <CastlesStrategy::Unit> ();
+
+    Urho3D::XMLFile *prefabFile = scene->GetSubsystem <Urho3D::ResourceCache> ()->
+            GetResource <Urho3D::XMLFile> (prefabPath);
+    if (prefabFile != nullptr)
+    {
+        CastlesStrategy::DataManager::CreateObjectPrefab (unitNode, prefabFile->GetRoot ());
+    }
+    return unitNode;
+}
+
+void UpdateScene (Urho3D::Scene *scene, Urho3D::Node *unitNode, unsigned int frame)
+{
+    if (frame % 2 == 0)
+    {
+        unitNode->Translate ({SERVER_STEP, 0.0f, 0.0f});
+    }
+    scene->Update (TIME_STEP);
+}
+
+float GetPrefabLag (Urho3D::Node *unitNode, const Urho3D::Vector3 &prefabOffset)
+{
+    Urho3D::Node *prefab = unitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME);
+    return (unitNode->GetWorldPosition () + prefabOffset - prefab->GetWorldPosition ()).Length ();
+}
@@ -0,0 +1,145 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Client/Ingame/DataManager.hpp>
+#include <CastlesStrategy/Client/Ingame/UnitMotionInterpolator.hpp>
+#include <CastlesStrategy/Shared/Unit/Unit.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+Urho3D::Node *CreateUnitWithPrefab (Urho3D::Scene *scene, const Urho3D::String &prefabPath, bool isEnabled);
+/// Returns true if prefab node and all its children have given enabled state.
+bool IsPrefabEnabled (Urho3D::Node *prefab, bool isEnabled);
+
+const Urho3D::String PREFAB_PATH ("DefaultUnits/Knight/Prefab.xml");
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    CastlesStrategy::Unit::RegisterObject (context);
+    CastlesStrategy::UnitMotionInterpolator::RegisterObject (context);
+    SetupEngine (engine);
+    Urho3D::SharedPtr <Urho3D::Scene> scene (new Urho3D::Scene (context));
+
+    Urho3D::Node *unitNode = CreateUnitWithPrefab (scene, PREFAB_PATH, true);
+    // Prefab files store their own node name, which must not hide prefab from enabled state updates.
+    Urho3D::Node *prefab = unitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME);
+    if (prefab == nullptr || prefab->GetNumChildren () == 0)
+    {
+        URHO3D_LOGERROR ("Prefab loaded from \"" + PREFAB_PATH + "\" must be found by prefab node name!");
+        return 1;
+    }
+
+    if (!prefab->HasComponent <CastlesStrategy::UnitMotionInterpolator> () || !IsPrefabEnabled (prefab, true))
+    {
+        URHO3D_LOGERROR ("Unit prefab must be enabled and must have motion interpolator!");
+        return 2;
+    }
+
+    // Server disables pooled dead units, prefab must be hidden with them.
+    unitNode->SetEnabled (false);
+    CastlesStrategy::DataManager::UpdateObjectPrefabEnabled (unitNode);
+    if (!IsPrefabEnabled (prefab, false))
+    {
+        URHO3D_LOGERROR ("Prefab of disabled unit node must be disabled with all its children!");
+        return 3;
+    }
+
+    unitNode->SetEnabled (true);
+    CastlesStrategy::DataManager::UpdateObjectPrefabEnabled (unitNode);
+    if (!IsPrefabEnabled (prefab, true))
+    {
+        URHO3D_LOGERROR ("Prefab of enabled again unit node must be enabled with all its children!");
+        return 4;
+    }
+
+    // Pooled unit can be replicated to client already disabled.
+    Urho3D::Node *disabledUnitNode = CreateUnitWithPrefab (scene, PREFAB_PATH, false);
+    Urho3D::Node *disabledPrefab = disabledUnitNode->GetChild (CastlesStrategy::OBJECT_PREFAB_NODE_NAME);
+    if (disabledPrefab == nullptr || !IsPrefabEnabled (disabledPrefab, false))
+    {
+        URHO3D_LOGERROR ("Prefab created for disabled unit node must be disabled!");
+        return 5;
+    }
+
+    disabledUnitNode->SetEnabled (true);
+    CastlesStrategy::DataManager::UpdateObjectPrefabEnabled (disabledUnitNode);
+    if (!IsPrefabEnabled (disabledPrefab, true))
+    {
+        URHO3D_LOGERROR ("Prefab created for disabled unit node must be enabled with unit node!");
+        return 6;
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestUnitPrefab.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Node *CreateUnitWithPrefab (Urho3D::Scene *scene, const Urho3D::String &prefabPath, bool isEnabled)
+{
+    Urho3D::Node *unitNode = scene->CreateChild ("Unit");
+    unitNode->CreateComponent <CastlesStrategy::Unit> ();
+    unitNode->SetEnabled (isEnabled);
+
+    Urho3D::XMLFile *prefabFile = scene->GetSubsystem <Urho3D::ResourceCache> ()->
+            GetResource <Urho3D::XMLFile> (prefabPath);
+    if (prefabFile != nullptr)
+    {
+        CastlesStrategy::DataManager::CreateObjectPrefab (unitNode, prefabFile->GetRoot ());
+    }
+    return unitNode;
+}
+
+bool IsPrefabEnabled (Urho3D::Node *prefab, bool isEnabled)
+{
+    if (prefab->IsEnabled () != isEnabled)
+    {
+        return false;
+    }
+
+    Urho3D::PODVector <Urho3D::Node *> children;
+    prefab->GetChildren (children, true);
+    for (Urho3D::Node *child : children)
+    {
+        if (child->IsEnabled () != isEnabled)
+        {
+            return false;
+        }
+    }
+    return true;
+}
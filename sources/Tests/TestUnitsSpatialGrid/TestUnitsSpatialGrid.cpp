@@ -0,0 +1,203 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/Random.h>
+
+#include <Utils/UniversalException.hpp>
+#include <CastlesStrategy/Server/Unit/UnitsSpatialGrid.hpp>
+
+void CustomTerminate ();
+void SetupEngine (Urho3D::Engine *engine);
+Urho3D::Vector3 RandomPosition (const Urho3D::Vector2 &mapSize);
+
+unsigned GetNearestBruteForce (const Urho3D::PODVector <Urho3D::Vector3> &positions, const Urho3D::Vector3 &position);
+void CollectUnitsNearBruteForce (const Urho3D::PODVector <Urho3D::Vector3> &positions, const Urho3D::Vector2 &position,
+        float radius, Urho3D::PODVector <unsigned> &output);
+
+int main (int argc, char **argv)
+{
+    std::set_terminate (CustomTerminate);
+    Urho3D::SharedPtr <Urho3D::Context> context (new Urho3D::Context());
+    Urho3D::SharedPtr <Urho3D::Engine> engine (new Urho3D::Engine(context));
+
+    context->GetSubsystem <Urho3D::Log> ()->SetLevel (Urho3D::LOG_DEBUG);
+    SetupEngine (engine);
+
+    const Urho3D::Vector2 MAP_SIZE = {100.0f, 60.0f};
+    const float CELL_SIZE = 7.0f;
+    const unsigned int UNITS_COUNT = 300;
+    const unsigned int QUERIES_COUNT = 1000;
+    const float MAX_RADIUS = 25.0f;
+    Urho3D::SetRandomSeed (42);
+
+    CastlesStrategy::UnitsSpatialGrid grid;
+    grid.Setup (MAP_SIZE, CELL_SIZE);
+
+    if (grid.GetNearest ({10.0f, 0.0f, 10.0f}) != Urho3D::M_MAX_UNSIGNED || grid.HasUnitNear ({10.0f, 0.0f, 10.0f}, 1000.0f))
+    {
+        URHO3D_LOGERROR ("Empty grid must not find any units!");
+        return 1;
+    }
+
+    // Some units are outside of map bounds, because crowd agents can be pushed out of it.
+    Urho3D::PODVector <Urho3D::Vector3> positions;
+    for (unsigned int index = 0; index < UNITS_COUNT; index++)
+    {
+        positions.Push (RandomPosition (MAP_SIZE));
+        grid.Insert (index, positions.Back ());
+    }
+
+    for (unsigned int query = 0; query < QUERIES_COUNT; query++)
+    {
+        Urho3D::Vector3 position = RandomPosition (MAP_SIZE);
+        float radius = Urho3D::Random (MAX_RADIUS);
+
+        unsigned int expectedNearest = GetNearestBruteForce (positions, position);
+        unsigned int nearest = grid.GetNearest (position);
+        if (nearest != expectedNearest)
+        {
+            URHO3D_LOGERROR ("Nearest unit to " + position.ToString () + " is " + Urho3D::String (expectedNearest) +
+                    ", but grid returned " + Urho3D::String (nearest) + "!");
+            return 2;
+        }
+
+        Urho3D::PODVector <unsigned> expectedNear;
+        CollectUnitsNearBruteForce (positions, {position.x_, position.z_}, radius, expectedNear);
+
+        // Output must be appended, not overwritten.
+        Urho3D::PODVector <unsigned> near;
+        near.Push (Urho3D::M_MAX_UNSIGNED);
+        grid.CollectUnitsNear ({position.x_, position.z_}, radius, near);
+
+        if (near.Size () != expectedNear.Size () + 1 || near.Front () != Urho3D::M_MAX_UNSIGNED)
+        {
+            URHO3D_LOGERROR ("Expected " + Urho3D::String (expectedNear.Size ()) + " units near " +
+                    position.ToString () + " in radius " + Urho3D::String (radius) + ", but grid collected " +
+                    Urho3D::String (near.Size () - 1) + "!");
+            return 3;
+        }
+
+        for (unsigned int index = 0; index < expectedNear.Size (); index++)
+        {
+            if (near [index + 1] != expectedNear [index])
+            {
+                URHO3D_LOGERROR ("Units collected by grid differ from brute force or are not sorted!");
+                return 4;
+            }
+        }
+
+        if (grid.HasUnitNear (position, radius) != !expectedNear.Empty ())
+        {
+            URHO3D_LOGERROR ("HasUnitNear for " + position.ToString () + " in radius " + Urho3D::String (radius) +
+                    " differs from brute force!");
+            return 5;
+        }
+    }
+
+    // Dead units are erased from grid and other units are moved to lower indices, like units state does it.
+    const unsigned int DEAD_UNITS_STEP = 3;
+    Urho3D::PODVector <unsigned> newIndices;
+    Urho3D::PODVector <Urho3D::Vector3> alivePositions;
+
+    for (unsigned int index = 0; index < positions.Size (); index++)
+    {
+        if (index % DEAD_UNITS_STEP == 0)
+        {
+            newIndices.Push (Urho3D::M_MAX_UNSIGNED);
+        }
+        else
+        {
+            newIndices.Push (alivePositions.Size ());
+            alivePositions.Push (positions [index]);
+        }
+    }
+
+    grid.RemapUnits (newIndices);
+    for (unsigned int query = 0; query < QUERIES_COUNT; query++)
+    {
+        Urho3D::Vector3 position = RandomPosition (MAP_SIZE);
+        float radius = Urho3D::Random (MAX_RADIUS);
+
+        Urho3D::PODVector <unsigned> expectedNear;
+        CollectUnitsNearBruteForce (alivePositions, {position.x_, position.z_}, radius, expectedNear);
+        Urho3D::PODVector <unsigned> near;
+        grid.CollectUnitsNear ({position.x_, position.z_}, radius, near);
+
+        if (grid.GetNearest (position) != GetNearestBruteForce (alivePositions, position) || near != expectedNear)
+        {
+            URHO3D_LOGERROR ("Remapped grid differs from brute force for " + position.ToString () + "!");
+            return 6;
+        }
+    }
+
+    grid.Clear ();
+    if (grid.GetNearest (positions.Front ()) != Urho3D::M_MAX_UNSIGNED)
+    {
+        URHO3D_LOGERROR ("Cleared grid must not find any units!");
+        return 7;
+    }
+    return 0;
+}
+
+void CustomTerminate ()
+{
+    try
+    {
+        std::rethrow_exception (std::current_exception ());
+    }
+
+    catch (AnyUniversalException &exception)
+    {
+        URHO3D_LOGERROR (exception.GetException ());
+    }
+    abort ();
+}
+
+void SetupEngine (Urho3D::Engine *engine)
+{
+    Urho3D::VariantMap engineParameters;
+    engineParameters [Urho3D::EP_HEADLESS] = true;
+    engineParameters [Urho3D::EP_WORKER_THREADS] = false;
+    engineParameters [Urho3D::EP_LOG_NAME] = "TestUnitsSpatialGrid.log";
+
+    engineParameters [Urho3D::EP_RESOURCE_PREFIX_PATHS] = "..;.";
+    engineParameters [Urho3D::EP_RESOURCE_PATHS] = "CoreData;TestData;Data";
+    engine->Initialize(engineParameters);
+}
+
+Urho3D::Vector3 RandomPosition (const Urho3D::Vector2 &mapSize)
+{
+    const float OUTSIDE_MARGIN = 10.0f;
+    return {Urho3D::Random (-OUTSIDE_MARGIN, mapSize.x_ + OUTSIDE_MARGIN), Urho3D::Random (2.0f),
+            Urho3D::Random (-OUTSIDE_MARGIN, mapSize.y_ + OUTSIDE_MARGIN)};
+}
+
+unsigned GetNearestBruteForce (const Urho3D::PODVector <Urho3D::Vector3> &positions, const Urho3D::Vector3 &position)
+{
+    unsigned nearest = Urho3D::M_MAX_UNSIGNED;
+    float minimumDistance = Urho3D::M_INFINITY;
+
+    for (unsigned index = 0; index < positions.Size (); index++)
+    {
+        float distance = (position - positions [index]).Length ();
+        if (distance < minimumDistance)
+        {
+            minimumDistance = distance;
+            nearest = index;
+        }
+    }
+    return nearest;
+}
+
+void CollectUnitsNearBruteForce (const Urho3D::PODVector <Urho3D::Vector3> &positions, const Urho3D::Vector2 &position,
+        float radius, Urho3D::PODVector <unsigned> &output)
+{
+    for (unsigned index = 0; index < positions.Size (); index++)
+    {
+        if ((Urho3D::Vector2 (positions [index].x_, positions [index].z_) - position).Length () <= radius)
+        {
+            output.Push (index);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Utils/UniversalException.hpp>
+
+/// Maps generational handles to dense indices. Handle stores slot in low 16 bits and slot generation in high 16 bits,
+/// so handle of released slot resolves to M_MAX_UNSIGNED even after slot is reused.
+class SlotMap
+{
+public:
+    SlotMap () : slots_ (), freeSlots_ () {}
+    virtual ~SlotMap () {}
+
+    unsigned Allocate (unsigned denseIndex)
+    {
+        unsigned slot;
+        if (!freeSlots_.Empty ())
+        {
+            slot = freeSlots_.Back ();
+            freeSlots_.Pop ();
+        }
+        else
+        {
+            // Last slot is not used, so M_MAX_UNSIGNED is never a valid handle.
+            if (slots_.Size () >= SLOT_MASK)
+            {
+                throw UniversalException <SlotMap> ("SlotMap: slots limit reached!");
+            }
+
+            slot = slots_.Size ();
+            slots_.Push ({0, denseIndex});
+        }
+
+        slots_ [slot].denseIndex_ = denseIndex;
+        return slots_ [slot].generation_ << GENERATION_SHIFT | slot;
+    }
+
+    void Release (unsigned handle)
+    {
+        if (Resolve (handle) != Urho3D::M_MAX_UNSIGNED)
+        {
+            Slot &slot = slots_ [handle & SLOT_MASK];
+            slot.generation_ = (slot.generation_ + 1) & SLOT_MASK;
+            slot.denseIndex_ = Urho3D::M_MAX_UNSIGNED;
+            freeSlots_.Push (handle & SLOT_MASK);
+        }
+    }
+
+    void Relocate (unsigned handle, unsigned denseIndex)
+    {
+        if (Resolve (handle) == Urho3D::M_MAX_UNSIGNED)
+        {
+            throw UniversalException <SlotMap> ("SlotMap: attempt to relocate stale handle!");
+        }
+        slots_ [handle & SLOT_MASK].denseIndex_ = denseIndex;
+    }
+
+    unsigned Resolve (unsigned handle) const
+    {
+        unsigned slot = handle & SLOT_MASK;
+        if (slot >= slots_.Size () || slots_ [slot].generation_ != handle >> GENERATION_SHIFT)
+        {
+            return Urho3D::M_MAX_UNSIGNED;
+        }
+        return slots_ [slot].denseIndex_;
+    }
+
+    void Clear ()
+    {
+        slots_.Clear ();
+        freeSlots_.Clear ();
+    }
+
+private:
+    static const unsigned GENERATION_SHIFT = 16;
+    static const unsigned SLOT_MASK = (1u << GENERATION_SHIFT) - 1;
+
+    struct Slot
+    {
+        unsigned generation_;
+        unsigned denseIndex_;
+    };
+
+    Urho3D::PODVector <Slot> slots_;
+    Urho3D::PODVector <unsigned> freeSlots_;
+};